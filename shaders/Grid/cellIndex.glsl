@@ -0,0 +1,143 @@
+//Cell numbering shared by the grid build and the simulation kernels.
+//Prepended by SimulationState::DefineConstants, must match SPH::CellIndex on the CPU.
+
+#ifdef CELL_ORDER_MORTON
+uint spreadBits(uint v)
+{
+    v &= 0x000003FFu;
+    v = (v | (v << 16)) & 0x030000FFu;
+    v = (v | (v << 8)) & 0x0300F00Fu;
+    v = (v | (v << 4)) & 0x030C30C3u;
+    v = (v | (v << 2)) & 0x09249249u;
+    return v;
+}
+
+uint compactBits(uint v)
+{
+    v &= 0x09249249u;
+    v = (v | (v >> 2)) & 0x030C30C3u;
+    v = (v | (v >> 4)) & 0x0300F00Fu;
+    v = (v | (v >> 8)) & 0x030000FFu;
+    v = (v | (v >> 16)) & 0x000003FFu;
+    return v;
+}
+#endif
+
+#ifdef CELL_ORDER_HASHED
+//Open addressing table with linear probing, one slot per occupied cell.
+//Cleared to EmptyCellKey before every grid build, filled by count.comp.
+layout(std430) restrict coherent buffer cellKeyBuffer
+{
+    uint cellKey[];
+};
+
+const uint EmptyCellKey = 0xFFFFFFFFu;
+const uint HashedAxisMask = (1u << HASHED_AXIS_BITS) - 1u;
+const uint HashSlotMask = NUM_CELL_SLOTS - 1u;
+
+//Coordinates wrap per axis, so a neighbour's key can be built from an unpacked one
+uint packCellKey(ivec3 cell)
+{
+    uvec3 wrapped = uvec3(cell) & HashedAxisMask;
+    return (wrapped.x << (2u * HASHED_AXIS_BITS)) | (wrapped.y << HASHED_AXIS_BITS) | wrapped.z;
+}
+
+ivec3 unpackCellKey(uint key)
+{
+    return ivec3(uvec3(key >> (2u * HASHED_AXIS_BITS), key >> HASHED_AXIS_BITS, key) & HashedAxisMask);
+}
+
+uint cellHash(ivec3 cell)
+{
+    uvec3 wrapped = uvec3(cell) & HashedAxisMask;
+    return ((wrapped.x * 73856093u) ^ (wrapped.y * 19349663u) ^ (wrapped.z * 83492791u)) & HashSlotMask;
+}
+#else
+uint cellIndex(uvec3 cell)
+{
+#ifdef CELL_ORDER_MORTON
+    return (spreadBits(cell.x) << 2) | (spreadBits(cell.y) << 1) | spreadBits(cell.z);
+#else
+    return cell.x * NUM_GRID_CELLS * NUM_GRID_CELLS + cell.y * NUM_GRID_CELLS + cell.z;
+#endif
+}
+
+uvec3 cellCoord(uint index)
+{
+#ifdef CELL_ORDER_MORTON
+    return uvec3(compactBits(index >> 2), compactBits(index >> 1), compactBits(index));
+#else
+    return uvec3(index / (NUM_GRID_CELLS * NUM_GRID_CELLS), (index / NUM_GRID_CELLS) % NUM_GRID_CELLS, index % NUM_GRID_CELLS);
+#endif
+}
+#endif
+
+//Cell containing a position. Unbounded when hashed, otherwise clamped to the grid
+//so particles pushed past the walls can't index out of range.
+ivec3 cellOfPosition(vec3 pos)
+{
+#ifdef CELL_ORDER_HASHED
+    return ivec3(floor((pos + 1.0) * (0.5 * float(NUM_GRID_CELLS))));
+#else
+    return clamp(ivec3((pos + 1.0) * float(NUM_GRID_CELLS)) / 2, ivec3(0), ivec3(NUM_GRID_CELLS - 1u));
+#endif
+}
+
+//Slot of a cell, inserting it into the hash table if it's not there yet
+uint claimCell(ivec3 cell)
+{
+#ifdef CELL_ORDER_HASHED
+    uint key = packCellKey(cell);
+    uint slot = cellHash(cell);
+
+    //There are at least as many slots as particles, so a free one is always found
+    for(uint probe = 0; probe < NUM_CELL_SLOTS; ++probe)
+    {
+        uint stored = atomicCompSwap(cellKey[slot], EmptyCellKey, key);
+        if(stored == EmptyCellKey || stored == key)
+            break;
+
+        slot = (slot + 1u) & HashSlotMask;
+    }
+    return slot;
+#else
+    return cellIndex(uvec3(cell));
+#endif
+}
+
+//Slot of a cell, false for cells outside the grid or, when hashed, cells without particles
+bool findCell(ivec3 cell, out uint slot)
+{
+#ifdef CELL_ORDER_HASHED
+    uint key = packCellKey(cell);
+    slot = cellHash(cell);
+
+    for(uint probe = 0; probe < NUM_CELL_SLOTS; ++probe)
+    {
+        uint stored = cellKey[slot];
+        if(stored == key)
+            return true;
+        if(stored == EmptyCellKey)
+            return false;
+
+        slot = (slot + 1u) & HashSlotMask;
+    }
+    return false;
+#else
+    if(any(lessThan(cell, ivec3(0))) || any(greaterThanEqual(cell, ivec3(NUM_GRID_CELLS))))
+        return false;
+
+    slot = cellIndex(uvec3(cell));
+    return true;
+#endif
+}
+
+//Coordinates of the cell in an occupied slot
+ivec3 slotCell(uint slot)
+{
+#ifdef CELL_ORDER_HASHED
+    return unpackCellKey(cellKey[slot]);
+#else
+    return ivec3(cellCoord(slot));
+#endif
+}
@@ -10,7 +10,7 @@
 
 layout(std430, binding = 0) restrict readonly buffer positionBuffer
 {
-    vec3 position[];
+    PARTICLE_VEC3_ARRAY(position);
 };
 
 struct gridIndex
@@ -31,12 +31,12 @@ layout(std430) restrict readonly buffer pressureBuffer
 
 layout(std430) restrict readonly buffer velocityBuffer
 {
-    vec3 velocity[];
+    PARTICLE_VEC3_ARRAY(velocity);
 };
 
 layout(std430) restrict readonly buffer forceBuffer
 {
-    vec3 force[];
+    PARTICLE_VEC3_ARRAY(force);
 };
 
 layout(std430) restrict readonly buffer densityBuffer
@@ -89,7 +89,7 @@ void main()
 
     position[id] = pos + strength * toTarget * 0.01;*/
 
-    vec3 pos = position[gl_VertexID];
+    vec3 pos = LOAD_VEC3(position, uint(gl_VertexID));
     //gridIndex grid = particleGridIndex[gl_VertexID];
 
     float pr = density[gl_VertexID] / 400;
@@ -6,12 +6,20 @@ in FragmentData
 };
 
 layout(location = 0) out vec4 outColor;
+//Normal and distance from the eye of the first shell sample, read by upsample.frag
+layout(location = 1) out vec4 outSurface;
 
 layout(location = 0) uniform sampler3D distanceText;
 
 layout(location = 1) uniform vec3 Eye;
 layout(location = 3) uniform int BoundaryType;
 layout(location = 4) uniform float BoundaryRadius;
+//0: fixed steps, 1: sphere tracing
+layout(location = 5) uniform int MarchMode;
+//Draws the number of loop iterations instead of the surface
+layout(location = 6) uniform bool ShowSteps;
+//Only marches pixels with (x + y) % 2 == Parity, all of them if negative; reproject.frag fills in the rest
+layout(location = 7) uniform int Parity;
 
 struct Plain
 {
@@ -32,18 +40,40 @@ const Plain borders[6] =
 };
 
 const float SampleStep = 0.005;
+const int MaxSteps = 400;
+
+//The surface is drawn in the shell between these distances from the edge particles
+const float ShellInner = 0.01;
+const float ShellOuter = 0.03;
+
+//Sphere tracing: closer than this to the shell the ray integrates it with SampleStep,
+//further away it steps by the distance to the shell but never less than MinStep
+const float HitEpsilon = 0.001;
+const float MinStep = 0.002;
+
+//SPH::DistanceFieldMaxRadius, the field is 1 beyond it
+const float MaxRadius = 0.08;
+
+//Sphere tracing first tests whole blocks of the min pyramid (levels 1 and up of distanceText).
+//A block is empty if its minimum is more than SkipMargin voxels above the shell: filtered samples
+//inside it also read the voxels just outside, which are less than two voxels closer.
+const int MinSkipLevel = 1;
+const float SkipMargin = 2.0;
+
+//Surface depth of rays that miss the shell, same as in upsample.frag and reproject.frag
+const float NoHitDepth = 1000.0;
 
 vec3 getNorm(vec3 pos)
 {
 	 vec3 norm;
-	 norm.x = texture(distanceText, pos + vec3(1, 0, 0) / 64.0).r - texture(distanceText, pos - vec3(1, 0, 0) / 64.0).r;
-	 norm.y = texture(distanceText, pos + vec3(0, 1, 0) / 64.0).r - texture(distanceText, pos - vec3(0, 1, 0) / 64.0).r;
-	 norm.z = texture(distanceText, pos + vec3(0, 0, 1) / 64.0).r - texture(distanceText, pos - vec3(0, 0, 1) / 64.0).r;
+	 norm.x = textureLod(distanceText, pos + vec3(1, 0, 0) / 64.0, 0).r - textureLod(distanceText, pos - vec3(1, 0, 0) / 64.0, 0).r;
+	 norm.y = textureLod(distanceText, pos + vec3(0, 1, 0) / 64.0, 0).r - textureLod(distanceText, pos - vec3(0, 1, 0) / 64.0, 0).r;
+	 norm.z = textureLod(distanceText, pos + vec3(0, 0, 1) / 64.0, 0).r - textureLod(distanceText, pos - vec3(0, 0, 1) / 64.0, 0).r;
 
 	 return normalize(norm);
 }
 
-vec3 shade(vec3 pos, vec3 ray)
+vec3 shade(vec3 norm, vec3 ray)
 {
 	const vec3 Kd = vec3(0, 0.807, 0.819);
 	const vec3 Ks = vec3(0, 0.907, 0.98);
@@ -51,8 +81,6 @@ vec3 shade(vec3 pos, vec3 ray)
 	const float sE = 8.0;
 	const vec3 to_light = normalize(vec3(0.3, 1, 0.3));
 
-	vec3 norm = getNorm(pos);
-
 	vec3 diffuse = 0.7 * min(abs(dot(to_light, norm)), 1) * color * Kd;
 
 	vec3 specular = pow(clamp(dot(reflect(-to_light, norm), -ray), 0, 1), sE) * Ks * color;
@@ -166,30 +194,94 @@ void hitBoundary(inout vec3 rayPos, vec3 rayDir)
 		hitSphere(rayPos, rayDir);
 }
 
+vec3 stepColor(int steps)
+{
+	float heat = float(steps) / float(MaxSteps);
+	return heat < 0.5 ?
+		mix(vec3(0, 0, 1), vec3(0, 1, 0), heat * 2) :
+		mix(vec3(0, 1, 0), vec3(1, 0, 0), heat * 2 - 1);
+}
+
+//Distance along the ray to just past the far side of the block of the given size around pos
+float blockExit(vec3 pos, vec3 dir, float blockSize)
+{
+	vec3 safeDir = mix(dir, vec3(1e-6), lessThan(abs(dir), vec3(1e-6)));
+	vec3 blockStart = floor(pos / blockSize) * blockSize;
+	vec3 exitPlane = blockStart + step(0.0, safeDir) * blockSize;
+	vec3 exitDist = (exitPlane - pos) / safeDir;
+
+	return min(min(exitDist.x, exitDist.y), exitDist.z) + 0.01 * blockSize;
+}
+
 void main()
 {
+	if(Parity >= 0 && ((int(gl_FragCoord.x) + int(gl_FragCoord.y)) & 1) != Parity)
+		discard;
+
 	const vec3 rayDir = normalize(rayStart - Eye);
 	vec3 rayPos = rayStart;
 	hitBoundary(rayPos, rayDir);
 
+	//Interpolating between the last stored distance and the saturated 1 can overestimate
+	//by up to a voxel, so the longest step stays a voxel short of the cutoff
+	const float voxelSize = 1.0 / float(textureSize(distanceText, 0).x);
+	const float maxStep = MaxRadius - ShellOuter - voxelSize;
+
+	//Moves up a level after every skipped block and down after every occupied one
+	const int topLevel = textureQueryLevels(distanceText) - 1;
+	int level = topLevel;
+
 	vec4 fragColor = vec4(0, 0, 0, 0);
 	vec4 color;
 	float dist = 0;
-	for(int i = 0; i < 400; ++i)
+	float rayStep = SampleStep;
+	int steps = 0;
+	vec4 surface = vec4(0, 0, 0, NoHitDepth);
+	for(; steps < MaxSteps; ++steps)
 	{
-		rayPos += SampleStep * rayDir;
+		rayPos += rayStep * rayDir;
 
 		if(!inBoundary(rayPos))
 			break;
 
-		dist = texture(distanceText, rayPos).r;
-		if(dist < 0.01 || dist > 0.03)
+		if(MarchMode == 1 && level >= MinSkipLevel)
+		{
+			float blockSize = voxelSize * float(1 << level);
+			if(texelFetch(distanceText, ivec3(rayPos / blockSize), level).r > ShellOuter + SkipMargin * voxelSize)
+			{
+				rayStep = blockExit(rayPos, rayDir, blockSize);
+				level = min(level + 1, topLevel);
+			}
+			else
+			{
+				rayStep = 0;
+				--level;
+			}
+			continue;
+		}
+
+		dist = textureLod(distanceText, rayPos, 0).r;
+
+		rayStep = SampleStep;
+		if(MarchMode == 1 && dist > ShellOuter + HitEpsilon)
+		{
+			rayStep = clamp(dist - ShellOuter, MinStep, maxStep);
+			//Away from every edge particle again, go back to skipping blocks
+			if(dist > MaxRadius)
+				level = min(MinSkipLevel, topLevel);
+		}
+
+		if(dist < ShellInner || dist > ShellOuter)
 			continue;
 
 		float x = dist - 0.02;
 		color.a = exp(-160000 * x * x) * SampleStep * 2;
 
-		color.rgb = shade(rayPos, rayDir);
+		vec3 norm = getNorm(rayPos);
+		if(surface.w == NoHitDepth)
+			surface = vec4(norm, distance(rayPos, Eye));
+
+		color.rgb = shade(norm, rayDir);
 
 		fragColor.rgb = fragColor.rgb * fragColor.a + color.rgb * (1 - fragColor.a);
 		fragColor.a += (1 - fragColor.a) * color.a;
@@ -199,5 +291,6 @@ void main()
 
 	}
 
-	outColor = fragColor;
+	outColor = ShowSteps ? vec4(stepColor(steps), 1) : fragColor;
+	outSurface = surface;
 }
@@ -0,0 +1,130 @@
+#version 450
+
+/*
+ * 棋盘格投射的重建（片段着色器）
+ * 输入：本帧 raycast.frag 只投射了奇偶性为 `Parity` 的像素（`currentColor`、`currentSurface`），
+ *       上一帧的完整结果（`historyColor`、`historySurface`）与上一帧的相机
+ * 输出：其余像素的颜色与表面。用相邻新像素的深度估计本像素光线上的命中点并投影到上一帧画面，
+ *       上一帧该处的深度与之一致时沿用上一帧的颜色，否则取相邻新像素的平均
+ * `HistoryExact` 表示上一帧与本帧的输入完全相同，直接复制同一像素
+ */
+
+in FragmentData
+{
+	vec3 rayStart;
+};
+
+layout(location = 0) out vec4 outColor;
+layout(location = 1) out vec4 outSurface;
+
+layout(location = 0) uniform sampler2D currentColor;
+layout(location = 1) uniform sampler2D currentSurface;
+// location 2 是 quad.vert 的 world
+layout(location = 3) uniform sampler2D historyColor;
+layout(location = 4) uniform sampler2D historySurface;
+
+layout(location = 5) uniform vec3 Eye;
+// 上一帧的相机位置与屏幕平面（左下角与两条边），与 RenderPoints 的平面参数含义相同
+layout(location = 6) uniform vec3 PrevEye;
+layout(location = 7) uniform vec3 PrevPlaneOrigin;
+layout(location = 8) uniform vec3 PrevPlaneAxisX;
+layout(location = 9) uniform vec3 PrevPlaneAxisY;
+layout(location = 10) uniform int Parity;
+layout(location = 11) uniform bool HistoryExact;
+
+// 未命中表面的深度，与 raycast.frag、upsample.frag 一致
+const float NoHitDepth = 1000.0;
+// 重投影点与上一帧深度之差的容许值，约为表面壳层厚度
+const float DepthTolerance = 0.02;
+
+const ivec2 neighbourOffsets[4] =
+{
+	ivec2(-1, 0), ivec2(1, 0), ivec2(0, -1), ivec2(0, 1)
+};
+
+// 点 pos 在上一帧画面中的像素，不在上一帧视野内时返回 false
+bool previousPixel(vec3 pos, out ivec2 pixel)
+{
+	vec3 ray = pos - PrevEye;
+	vec3 n = cross(PrevPlaneAxisX, PrevPlaneAxisY);
+	float denom = dot(ray, n);
+	if(abs(denom) < 1e-6)
+		return false;
+
+	float t = dot(PrevPlaneOrigin - PrevEye, n) / denom;
+	if(t <= 0)
+		return false;
+
+	vec3 rel = PrevEye + t * ray - PrevPlaneOrigin;
+
+	float aa = dot(PrevPlaneAxisX, PrevPlaneAxisX);
+	float ab = dot(PrevPlaneAxisX, PrevPlaneAxisY);
+	float bb = dot(PrevPlaneAxisY, PrevPlaneAxisY);
+	float ra = dot(rel, PrevPlaneAxisX);
+	float rb = dot(rel, PrevPlaneAxisY);
+	float det = aa * bb - ab * ab;
+
+	vec2 uv = vec2(ra * bb - rb * ab, rb * aa - ra * ab) / det;
+	if(any(lessThan(uv, vec2(0))) || any(greaterThanEqual(uv, vec2(1))))
+		return false;
+
+	pixel = ivec2(uv * vec2(textureSize(historySurface, 0)));
+	return true;
+}
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	if(((pixel.x + pixel.y) & 1) == Parity)
+		discard;
+
+	if(HistoryExact)
+	{
+		outColor = texelFetch(historyColor, pixel, 0);
+		outSurface = texelFetch(historySurface, pixel, 0);
+		return;
+	}
+
+	const ivec2 size = textureSize(currentSurface, 0);
+	const vec3 rayDir = normalize(rayStart - Eye);
+
+	vec4 colorSum = vec4(0);
+	float count = 0.0;
+	vec4 nearestSurface = vec4(0, 0, 0, NoHitDepth);
+	for(int i = 0; i < 4; ++i)
+	{
+		ivec2 neighbour = pixel + neighbourOffsets[i];
+		if(any(lessThan(neighbour, ivec2(0))) || any(greaterThanEqual(neighbour, size)))
+			continue;
+
+		vec4 color = texelFetch(currentColor, neighbour, 0);
+		vec4 surface = texelFetch(currentSurface, neighbour, 0);
+		colorSum += vec4(color.rgb * color.a, color.a);
+		count += 1.0;
+
+		if(surface.w >= NoHitDepth)
+			continue;
+
+		if(surface.w < nearestSurface.w)
+			nearestSurface = surface;
+
+		// 假设本像素的光线与该相邻像素命中同一表面
+		vec3 hit = Eye + surface.w * rayDir;
+
+		ivec2 previous;
+		if(!previousPixel(hit, previous))
+			continue;
+
+		vec4 history = texelFetch(historySurface, previous, 0);
+		if(history.w < NoHitDepth && abs(history.w - distance(hit, PrevEye)) < DepthTolerance)
+		{
+			outColor = texelFetch(historyColor, previous, 0);
+			outSurface = vec4(history.xyz, surface.w);
+			return;
+		}
+	}
+
+	// 没有一致的历史（新露出的区域或未命中）：相邻新像素按不透明度预乘后取平均
+	outColor = colorSum.a > 0.0 ? vec4(colorSum.rgb / colorSum.a, colorSum.a / count) : vec4(0);
+	outSurface = nearestSurface;
+}
@@ -0,0 +1,63 @@
+#version 450
+
+/*
+ * 低分辨率光线投射结果的深度感知上采样（联合双边滤波）
+ * 输入：`lowColor`（raycast.frag 的颜色与不透明度）、`lowSurface`（首个命中点的法线与深度）、`LowScale`
+ * 输出：窗口分辨率的颜色，与直接投射一样按不透明度混合到背景上
+ * 每个像素取最近的 2x2 个低分辨率样本，双线性权重再乘以与最近样本的深度、法线相似度，轮廓两侧不会互相混色
+ */
+
+layout(location = 0) out vec4 outColor;
+
+layout(location = 0) uniform sampler2D lowColor;
+layout(location = 1) uniform sampler2D lowSurface;
+// 低分辨率目标与窗口的尺寸之比（location 2 是 quad.vert 的 world）
+layout(location = 3) uniform vec2 LowScale;
+
+// 未命中表面的深度，与 raycast.frag、reproject.frag 一致
+const float NoHitDepth = 1000.0;
+
+// 深度差约为表面壳层厚度时权重降到 1/e
+const float DepthSigma = 0.02;
+// 法线夹角的权重指数
+const float NormalPower = 8.0;
+
+void main()
+{
+	const ivec2 lowSize = textureSize(lowColor, 0);
+	vec2 lowPos = gl_FragCoord.xy * LowScale - 0.5;
+	ivec2 base = ivec2(floor(lowPos));
+	vec2 fraction = lowPos - vec2(base);
+
+	// 最近的低分辨率样本作为引导
+	ivec2 nearest = clamp(ivec2(floor(lowPos + 0.5)), ivec2(0), lowSize - 1);
+	vec4 guide = texelFetch(lowSurface, nearest, 0);
+
+	vec4 colorSum = vec4(0);
+	float weightSum = 0.0;
+	for(int i = 0; i < 4; ++i)
+	{
+		ivec2 offset = ivec2(i & 1, i >> 1);
+		ivec2 coord = clamp(base + offset, ivec2(0), lowSize - 1);
+		vec4 surface = texelFetch(lowSurface, coord, 0);
+
+		vec2 bilinear = mix(1.0 - fraction, fraction, vec2(offset));
+		float depthDiff = (surface.w - guide.w) / DepthSigma;
+		float weight = bilinear.x * bilinear.y * exp(-depthDiff * depthDiff);
+
+		// 都命中时才比较法线，未命中的样本法线为 0
+		if(surface.w < NoHitDepth && guide.w < NoHitDepth)
+			weight *= pow(max(dot(surface.xyz, guide.xyz), 0.0), NormalPower);
+
+		// 按不透明度预乘后插值，透明样本的颜色不会把边缘染黑
+		vec4 color = texelFetch(lowColor, coord, 0);
+		colorSum += weight * vec4(color.rgb * color.a, color.a);
+		weightSum += weight;
+	}
+
+	// 最近样本自身的权重至少为 1/4，weightSum 不会为 0
+	float alpha = colorSum.a / weightSum;
+	vec3 rgb = colorSum.a > 0.0 ? colorSum.rgb / colorSum.a : vec3(0);
+
+	outColor = vec4(rgb, alpha);
+}
@@ -0,0 +1,42 @@
+//Mirror images of neighbours across the box walls for the PCISPH kernels, see SPH::WallMirror.
+//Prepended by PressureSolverProgram together with WALL_BOUNDARY, before the KernelParams
+//block is declared, so the kernel constants are passed in.
+
+//SPH::WallPosition
+const float WallPosition = 1.0;
+
+struct WallMirror
+{
+    vec3 plane;
+    uint axisMask;
+};
+
+//Mirror planes half a rest spacing beyond the walls, only for axes within reach, SPH::MakeWallMirror
+WallMirror makeWallMirror(vec3 pos, float smoothingLength, float mass, float restDensity)
+{
+    float plane = WallPosition + 0.5 * pow(mass / restDensity, 1.0 / 3.0);
+
+    WallMirror mirror = WallMirror(vec3(0), 0u);
+    for(int axis = 0; axis < 3; ++axis)
+    {
+        if(pos[axis] + plane < smoothingLength)
+        {
+            mirror.plane[axis] = -plane;
+            mirror.axisMask |= 1u << axis;
+        }
+        else if(plane - pos[axis] < smoothingLength)
+        {
+            mirror.plane[axis] = plane;
+            mirror.axisMask |= 1u << axis;
+        }
+    }
+
+    return mirror;
+}
+
+//Image of a neighbour for one non-empty subset of axisMask,
+//iterated as subset = axisMask; subset != 0; subset = (subset - 1) & axisMask
+vec3 mirrorImage(WallMirror mirror, vec3 pos, uint subset)
+{
+    return mix(pos, 2.0 * mirror.plane - pos, notEqual(uvec3(subset) & uvec3(1u, 2u, 4u), uvec3(0u)));
+}
@@ -0,0 +1,93 @@
+/**
+ * @file Fence.hpp
+ * @brief 封装 OpenGL 栅栏同步对象（GLsync）。
+ */
+
+#ifndef FENCE_HPP
+#define FENCE_HPP
+
+#include <GL/glew.h>
+#include <utility>
+
+namespace GL {
+
+/**
+ * @brief 对 GLsync 的 RAII 封装，用于在不阻塞管线的情况下查询 GPU 进度。
+ */
+class Fence
+{
+private:
+	GLsync sync;
+public:
+	inline Fence() :
+		sync(nullptr)
+	{
+	}
+
+	inline ~Fence()
+	{
+		Clear();
+	}
+
+	Fence(const Fence&) = delete;
+	Fence& operator=(const Fence&) = delete;
+
+	inline Fence(Fence&& other) :
+		sync(other.sync)
+	{
+		other.sync = nullptr;
+	}
+
+	inline Fence& operator=(Fence&& other)
+	{
+		std::swap(sync, other.sync);
+		return *this;
+	}
+
+	/**
+	 * @brief 在命令流当前位置插入栅栏，替换之前的栅栏。
+	 */
+	inline void Insert()
+	{
+		Clear();
+		sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	/**
+	 * @brief 删除栅栏，之后 IsPending 返回 false。
+	 */
+	inline void Clear()
+	{
+		if(sync != nullptr)
+		{
+			glDeleteSync(sync);
+			sync = nullptr;
+		}
+	}
+
+	/**
+	 * @brief 栅栏已插入且尚未被删除。
+	 */
+	inline bool IsPending() const
+	{
+		return sync != nullptr;
+	}
+
+	/**
+	 * @brief 非阻塞地查询栅栏之前的命令是否已全部完成。
+	 * @return 已完成返回 true；未插入栅栏时也返回 true。
+	 */
+	inline bool IsSignaled() const
+	{
+		if(sync == nullptr)
+			return true;
+
+		//Zero timeout never blocks; flushing makes sure the fence eventually reaches the GPU
+		const GLenum result = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+	}
+};
+
+} //namespace GL
+
+#endif //FENCE_HPP
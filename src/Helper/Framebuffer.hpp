@@ -0,0 +1,90 @@
+/**
+ * @file Framebuffer.hpp
+ * @brief 封装 OpenGL 帧缓冲对象，用于渲染到纹理。
+ */
+
+#ifndef FRAMEBUFFER_HPP
+#define FRAMEBUFFER_HPP
+
+#include <GL/glew.h>
+
+#include "Texture.h"
+
+namespace GL {
+
+/**
+ * @brief 对 OpenGL 帧缓冲对象的简单封装，颜色附件直接引用 GL::Texture。
+ */
+class Framebuffer
+{
+private:
+	GLuint id;
+public:
+	/**
+	 * @brief 构造函数，创建一个没有附件的帧缓冲对象。
+	 */
+	inline Framebuffer()
+	{
+		glCreateFramebuffers(1, &id);
+	}
+
+	Framebuffer(const Framebuffer&) = delete;
+
+	Framebuffer& operator=(const Framebuffer&) = delete;
+
+	inline ~Framebuffer()
+	{
+		glDeleteFramebuffers(1, &id);
+	}
+
+	/**
+	 * @brief 把纹理的第 0 层作为第 index 个颜色附件。
+	 * @param index 颜色附件序号，片段着色器输出 location 与之对应。
+	 * @param texture 二维纹理，替换掉该附件原有的纹理。
+	 */
+	inline void AttachColor(GLuint index, const Texture& texture)
+	{
+		glNamedFramebufferTexture(id, GL_COLOR_ATTACHMENT0 + index, texture.GetId(), 0);
+	}
+
+	/**
+	 * @brief 写入前 count 个颜色附件。
+	 */
+	inline void DrawColorAttachments(GLsizei count)
+	{
+		GLenum buffers[8];
+		for(GLsizei i = 0; i < count && i < 8; ++i)
+			buffers[i] = GL_COLOR_ATTACHMENT0 + i;
+		glNamedFramebufferDrawBuffers(id, count < 8 ? count : 8, buffers);
+	}
+
+	/**
+	 * @brief 附件是否完整，可以作为绘制目标。
+	 */
+	inline bool IsComplete() const
+	{
+		return glCheckNamedFramebufferStatus(id, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	}
+
+	inline void Bind() const
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, id);
+	}
+
+	/**
+	 * @brief 恢复绘制到窗口的默认帧缓冲。
+	 */
+	inline static void BindDefault()
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	inline GLuint GetId() const
+	{
+		return id;
+	}
+};
+
+} //namespace GL
+
+#endif //FRAMEBUFFER_HPP
@@ -21,10 +21,26 @@ namespace GL {
  */
 bool Program::VsFsProgram( const std::string& vertexShaderName,
 	const std::string& fragmentShaderName)
+{
+	return VsFsProgram(vertexShaderName, fragmentShaderName, [](Shader&) {});
+}
+
+/**
+ * @brief 从文件加载顶点和片段着色器并构建、链接程序，编译前先配置顶点着色器。
+ * @param vertexShaderName 顶点着色器文件名。
+ * @param fragmentShaderName 片段着色器文件名。
+ * @param configureVertex 编译顶点着色器前调用的回调。
+ * @return 创建和链接成功返回 true，失败返回 false。
+ */
+bool Program::VsFsProgram( const std::string& vertexShaderName,
+	const std::string& fragmentShaderName,
+	const std::function<void(Shader&)>& configureVertex)
 {
 	Shader vertexShader(GL_VERTEX_SHADER);
 	Shader fragmentShader(GL_FRAGMENT_SHADER);
 
+	configureVertex(vertexShader);
+
 	bool valid = true;
 	if(!vertexShader.FromFile(vertexShaderName))
 	{
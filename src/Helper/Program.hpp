@@ -9,6 +9,7 @@
 #include <GL/glew.h>
 #include <string>
 #include <memory>
+#include <functional>
 
 #include "Shader.hpp"
 
@@ -186,6 +187,14 @@ public:
 
 	bool VsFsProgram( 	const std::string& vertexShaderName,
 						const std::string& fragmentShaderName);
+
+	/**
+	 * @brief 同上，但在编译前允许调用方配置顶点着色器（例如注入宏定义）。
+	 * @param configureVertex 编译顶点着色器前调用的回调。
+	 */
+	bool VsFsProgram( 	const std::string& vertexShaderName,
+						const std::string& fragmentShaderName,
+						const std::function<void(Shader&)>& configureVertex);
 };
 
 }// namespace GL;
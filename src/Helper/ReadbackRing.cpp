@@ -0,0 +1,73 @@
+/**
+ * @file ReadbackRing.cpp
+ * @brief 实现 ReadbackRing 的持久映射与栅栏轮询。
+ */
+
+#include "ReadbackRing.hpp"
+
+namespace GL {
+
+ReadbackRing::ReadbackRing(GLuint _slotSize, GLuint slotCount) :
+	mapped(nullptr),
+	slotSize(_slotSize),
+	fences(slotCount),
+	sequence(slotCount, 0),
+	nextSequence(0),
+	latestSequence(0),
+	nextSlot(0),
+	latest(_slotSize, 0)
+{
+	const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glNamedBufferStorage(buffer.GetId(), slotSize * slotCount, nullptr, flags);
+	mapped = glMapNamedBufferRange(buffer.GetId(), 0, slotSize * slotCount, flags);
+
+	if(mapped == nullptr)
+	{
+		Logger::Error() << "Couldn't persistently map readback buffer " << buffer.GetId() << '\n';
+	}
+}
+
+ReadbackRing::~ReadbackRing()
+{
+	if(mapped != nullptr)
+	{
+		glUnmapNamedBuffer(buffer.GetId());
+	}
+}
+
+void ReadbackRing::Capture(const Buffer& source, GLuint offset)
+{
+	glCopyNamedBufferSubData(source.GetId(), buffer.GetId(), offset, nextSlot * slotSize, slotSize);
+
+	fences[nextSlot].Insert();
+	sequence[nextSlot] = ++nextSequence;
+
+	nextSlot = (nextSlot + 1) % fences.size();
+}
+
+bool ReadbackRing::Poll()
+{
+	if(mapped == nullptr)
+		return false;
+
+	const unsigned long long previous = latestSequence;
+
+	for(GLuint slot = 0; slot < fences.size(); ++slot)
+	{
+		if(!fences[slot].IsPending() || !fences[slot].IsSignaled())
+			continue;
+
+		fences[slot].Clear();
+
+		if(sequence[slot] > latestSequence)
+		{
+			latestSequence = sequence[slot];
+			std::memcpy(latest.data(), static_cast<const unsigned char*>(mapped) + slot * slotSize, slotSize);
+		}
+	}
+
+	return latestSequence != previous;
+}
+
+} //namespace GL
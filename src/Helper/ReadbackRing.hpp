@@ -0,0 +1,87 @@
+/**
+ * @file ReadbackRing.hpp
+ * @brief 声明基于持久映射缓冲的异步回读环。
+ */
+
+#ifndef READBACK_RING_HPP
+#define READBACK_RING_HPP
+
+#include <GL/glew.h>
+
+#include "Buffer.hpp"
+#include "Fence.hpp"
+
+#include <cstring>
+#include <vector>
+
+namespace GL {
+
+/**
+ * @brief 把 GPU 缓冲中的一小段数据异步拷贝回主存。
+ *
+ * 每个槽位对应持久、一致映射缓冲中的一段区域及一个栅栏。Capture 只记录拷贝命令，
+ * Poll 在栅栏完成后才读取映射内存，因此 CPU 永远不会等待 GPU；代价是数据会滞后若干帧。
+ */
+class ReadbackRing
+{
+private:
+	Buffer buffer;
+	const void* mapped;
+
+	const GLuint slotSize;
+
+	std::vector<Fence> fences;
+	std::vector<unsigned long long> sequence;
+
+	unsigned long long nextSequence;
+	unsigned long long latestSequence;
+	GLuint nextSlot;
+
+	std::vector<unsigned char> latest;
+public:
+	/**
+	 * @param _slotSize 每次回读的字节数。
+	 * @param slotCount 同时在途的回读数量，应覆盖 CPU 领先 GPU 的帧数。
+	 */
+	ReadbackRing(GLuint _slotSize, GLuint slotCount = 3);
+	~ReadbackRing();
+
+	ReadbackRing(const ReadbackRing&) = delete;
+	ReadbackRing& operator=(const ReadbackRing&) = delete;
+
+	/**
+	 * @brief 记录从 source 的 offset 处拷贝 slotSize 字节到下一个槽位的命令。
+	 *
+	 * 若该槽位上一次的回读尚未完成，它会被丢弃，由更新的数据替代。
+	 */
+	void Capture(const Buffer& source, GLuint offset = 0);
+
+	/**
+	 * @brief 收集所有已完成的槽位，保留其中最新的一次结果。
+	 * @return 自上次调用以来是否有新的结果。
+	 */
+	bool Poll();
+
+	/**
+	 * @brief 最近一次已完成的回读结果；尚无结果时全部为 0。
+	 */
+	template<typename T>
+	T Latest() const
+	{
+		T value{};
+		std::memcpy(&value, latest.data(), sizeof(T) < latest.size() ? sizeof(T) : latest.size());
+		return value;
+	}
+
+	/**
+	 * @brief 最近结果距最新一次 Capture 滞后的次数。
+	 */
+	inline unsigned long long Lag() const
+	{
+		return nextSequence - latestSequence;
+	}
+};
+
+} //namespace GL
+
+#endif //READBACK_RING_HPP
@@ -71,6 +71,50 @@ std::string Shader::GetInfoLog() const
 	return std::string(errorMessage.get());
 }
 
+/**
+ * @brief 添加一个编译期宏。
+ * @param name 宏名。
+ * @param value 宏的值，为空时仅定义宏名。
+ */
+void Shader::Define(const std::string& name, const std::string& value)
+{
+	defines += "#define " + name;
+	if(!value.empty())
+	{
+		defines += ' ' + value;
+	}
+	defines += '\n';
+}
+
+/**
+ * @brief 添加一个无符号整数宏。
+ * @param name 宏名。
+ * @param value 宏的值。
+ */
+void Shader::Define(const std::string& name, unsigned value)
+{
+	Define(name, std::to_string(value) + 'u');
+}
+
+/**
+ * @brief 插入一个公共 GLSL 文件。
+ * @param fileName 文件路径。
+ * @return 文件读取成功返回 true。
+ */
+bool Shader::Include(const std::string& fileName)
+{
+	const std::string code = ReadShader(fileName);
+	if(code.empty())
+		return false;
+
+	defines += code;
+	if(code.back() != '\n')
+	{
+		defines += '\n';
+	}
+	return true;
+}
+
 /**
  * @brief 从文件加载着色器源代码并编译。
  * @param fileName 着色器文件路径。
@@ -94,8 +138,22 @@ bool Shader::FromString(const std::string& source)
 		return false;
 	}
 
+	//#version has to stay the first statement, so defines go right after it.
+	//#line keeps the line numbers in the info log matching the file.
+	std::string fullSource = source;
+	if(!defines.empty())
+	{
+		std::string::size_type insertAt = 0;
+		if(fullSource.compare(0, 8, "#version") == 0)
+		{
+			insertAt = fullSource.find('\n');
+			insertAt = insertAt == std::string::npos ? fullSource.size() : insertAt + 1;
+		}
+		fullSource.insert(insertAt, defines + "#line " + (insertAt == 0 ? "1" : "2") + '\n');
+	}
+
 	const char* str1[1];
-	str1[0] = source.c_str();
+	str1[0] = fullSource.c_str();
 	glShaderSource( shaderId, 1, str1, NULL );
 
 	// Compile shader
@@ -19,6 +19,9 @@ class Shader
 {
 private:
 	GLuint shaderId;
+
+	// 编译前插入到 #version 之后的宏定义与公共代码
+	std::string defines;
 public:
 	/**
 	 * @brief 构造函数，创建指定类型的着色器对象。
@@ -46,7 +49,8 @@ public:
 	 * @brief 移动构造函数，转移着色器所有权。
 	 */
 	inline Shader(Shader&& other) :
-		shaderId(other.shaderId)
+		shaderId(other.shaderId),
+		defines(std::move(other.defines))
 	{
 		other.shaderId = 0;
 	}
@@ -57,6 +61,7 @@ public:
 	inline Shader& operator=(Shader&& other)
 	{
 		std::swap(shaderId, other.shaderId);
+		std::swap(defines, other.defines);
 		return *this;
 	}
 
@@ -79,6 +84,25 @@ public:
 
 	std::string GetInfoLog() const;
 
+	/**
+	 * @brief 添加一个编译期宏，须在 FromFile/FromString 之前调用。
+	 * @param name 宏名。
+	 * @param value 宏的值，为空时仅定义宏名。
+	 */
+	void Define(const std::string& name, const std::string& value = "");
+
+	/**
+	 * @brief 添加一个无符号整数宏，值以 GLSL 的 u 后缀写出。
+	 */
+	void Define(const std::string& name, unsigned value);
+
+	/**
+	 * @brief 把一个 GLSL 文件的内容插入到已添加的宏之后，用于多个着色器共用的函数。
+	 * @param fileName 被插入的文件路径。
+	 * @return 文件读取成功返回 true。
+	 */
+	bool Include(const std::string& fileName);
+
 	bool FromFile(const std::string& fileName);
 
 	bool FromString(const std::string& source);
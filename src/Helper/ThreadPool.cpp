@@ -0,0 +1,113 @@
+/**
+ * @file ThreadPool.cpp
+ * @brief 实现线程池的工作线程调度与 ParallelFor。
+ */
+
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threadCount) :
+	job(nullptr),
+	jobCount(0),
+	jobGrain(1),
+	nextIndex(0),
+	generation(0),
+	pendingWorkers(0),
+	stopping(false)
+{
+	const unsigned workerCount = threadCount > 1 ? threadCount - 1 : 0;
+
+	workers.reserve(workerCount);
+	for(unsigned i = 0; i < workerCount; ++i)
+	{
+		workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+
+	for(std::thread& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+void ThreadPool::ParallelFor(std::size_t count, const Body& body, std::size_t grain)
+{
+	if(count == 0)
+		return;
+
+	if(grain == 0)
+		grain = std::max<std::size_t>(1, count / (Size() * 4));
+
+	if(workers.empty() || count <= grain)
+	{
+		for(std::size_t begin = 0; begin < count; begin += grain)
+		{
+			body(begin, std::min(begin + grain, count));
+		}
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+	job = &body;
+	jobCount = count;
+	jobGrain = grain;
+	nextIndex = 0;
+	pendingWorkers = static_cast<unsigned>(workers.size());
+	++generation;
+	lock.unlock();
+
+	wake.notify_all();
+
+	//The calling thread takes chunks as well instead of idling
+	RunChunks();
+
+	lock.lock();
+	done.wait(lock, [this]{ return pendingWorkers == 0; });
+	job = nullptr;
+}
+
+void ThreadPool::WorkerLoop()
+{
+	unsigned seenGeneration = 0;
+
+	while(true)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		wake.wait(lock, [&]{ return stopping || generation != seenGeneration; });
+
+		if(stopping)
+			return;
+
+		seenGeneration = generation;
+		lock.unlock();
+
+		RunChunks();
+
+		lock.lock();
+		if(--pendingWorkers == 0)
+		{
+			done.notify_one();
+		}
+	}
+}
+
+void ThreadPool::RunChunks()
+{
+	while(true)
+	{
+		const std::size_t begin = nextIndex.fetch_add(jobGrain);
+		if(begin >= jobCount)
+			return;
+
+		(*job)(begin, std::min(begin + jobGrain, jobCount));
+	}
+}
@@ -0,0 +1,72 @@
+/**
+ * @file ThreadPool.hpp
+ * @brief 声明用于 CPU 并行计算的简单线程池。
+ */
+
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief 固定大小的线程池，只提供阻塞式的 ParallelFor。
+ *
+ * 调用线程本身也参与计算，因此 threadCount 个线程中只会创建 threadCount - 1 个工作线程。
+ */
+class ThreadPool
+{
+public:
+	/**
+	 * @brief 区间任务，参数为 [begin, end)。
+	 */
+	using Body = std::function<void(std::size_t, std::size_t)>;
+
+	explicit ThreadPool(unsigned threadCount = std::thread::hardware_concurrency());
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/**
+	 * @brief 将 [0, count) 切分为大小为 grain 的块并行执行，全部完成后返回。
+	 * @param count 元素数量。
+	 * @param body 处理一个区间的函数。
+	 * @param grain 每块的大小，为 0 时按线程数自动选择。
+	 */
+	void ParallelFor(std::size_t count, const Body& body, std::size_t grain = 0);
+
+	/**
+	 * @brief 获取参与计算的线程总数（包含调用线程）。
+	 */
+	unsigned Size() const
+	{
+		return static_cast<unsigned>(workers.size()) + 1;
+	}
+
+private:
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+
+	const Body* job;
+	std::size_t jobCount;
+	std::size_t jobGrain;
+	std::atomic<std::size_t> nextIndex;
+
+	unsigned generation;
+	unsigned pendingWorkers;
+	bool stopping;
+
+	void WorkerLoop();
+	void RunChunks();
+};
+
+#endif //THREAD_POOL_HPP
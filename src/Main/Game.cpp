@@ -19,9 +19,11 @@
 
 /**
  * @brief 构造 Game 对象，初始化运行标志等成员。
+ * @param _simulationConfig 模拟场景使用的粒子数、网格分辨率与计算后端。
  */
-Game::Game() :
-	running(true)
+Game::Game(const SimulationConfig& _simulationConfig) :
+	running(true),
+	simulationConfig(_simulationConfig)
 {
 }
 
@@ -95,7 +97,7 @@ bool Game::Init()
 
 	//Starting main Scene
 	sceneManager.AttachGame(this);
-	if(!sceneManager.ChangeScene(std::make_unique<SPHWaterScene>()))
+	if(!sceneManager.ChangeScene(std::make_unique<SPHWaterScene>(simulationConfig)))
 	{
 		Logger::Error() << "Failed initializing first scene. Exiting\n";
 		return false;
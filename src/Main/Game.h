@@ -6,11 +6,12 @@
 #include "ScaledDeltaTimer.h"
 #include "../Manager/SceneManager.h"
 #include "../Manager/WindowManager.h"
+#include "../SPHSimulation/SimulationConfig.hpp"
 
 class Game
 {
 public:
-	Game();
+	Game(const SimulationConfig& _simulationConfig = SimulationConfig());
 	void Run();
 
 	bool running;
@@ -27,4 +28,5 @@ private:
 	WindowManager windowManager;
 	ScaledDeltaTimer timer;
 	unsigned short targetFPS = 60;
+	SimulationConfig simulationConfig;
 };
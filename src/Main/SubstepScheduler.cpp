@@ -0,0 +1,72 @@
+/**
+ * @file SubstepScheduler.cpp
+ * @brief 实现 SubstepScheduler 的补步与速度比统计。
+ */
+
+#include "SubstepScheduler.h"
+
+#include <cmath>
+
+namespace
+{
+
+// Length of the window the simulated/real ratio is averaged over
+constexpr double RatioWindow = 1.0;
+
+} //unnamed namespace
+
+SubstepScheduler::SubstepScheduler(double _stepTime, unsigned _maxStepsPerFrame) :
+	stepTime(_stepTime),
+	maxStepsPerFrame(_maxStepsPerFrame > 0 ? _maxStepsPerFrame : 1),
+	backlog(0),
+	droppedTime(0),
+	fellBehind(false),
+	windowReal(0),
+	windowSimulated(0),
+	ratio(0)
+{
+}
+
+/**
+ * @brief 累积帧间时间，按预算取出本帧步数，超出预算的积压只保留不足一步的部分。
+ * @param delta 本帧经过的真实时间（秒）。
+ * @return 本帧应执行的步数。
+ */
+unsigned SubstepScheduler::BeginFrame(double delta)
+{
+	backlog += delta;
+
+	windowReal += delta;
+	if(windowReal >= RatioWindow)
+	{
+		ratio = windowSimulated / windowReal;
+		windowReal = 0;
+		windowSimulated = 0;
+	}
+
+	const double due = std::floor(backlog / stepTime);
+	unsigned steps = static_cast<unsigned>(due);
+
+	fellBehind = due > maxStepsPerFrame;
+	if(fellBehind)
+	{
+		steps = maxStepsPerFrame;
+
+		//Keep the fractional step so the phase is preserved, drop the rest
+		const double kept = std::fmod(backlog, stepTime);
+		droppedTime += backlog - steps * stepTime - kept;
+		backlog = kept + steps * stepTime;
+	}
+
+	backlog -= steps * stepTime;
+	return steps;
+}
+
+/**
+ * @brief 记录一步推进的模拟时间。
+ * @param simulatedTime 该步的积分时间步长（秒）。
+ */
+void SubstepScheduler::RecordStep(double simulatedTime)
+{
+	windowSimulated += simulatedTime;
+}
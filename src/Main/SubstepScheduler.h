@@ -0,0 +1,95 @@
+/**
+ * @file SubstepScheduler.h
+ * @brief 声明把帧间时间换算为固定步长模拟步数的调度器。
+ */
+
+#ifndef SUBSTEP_SCHEDULER_H
+#define SUBSTEP_SCHEDULER_H
+
+/**
+ * @brief 固定步长的子步调度：累积帧间时间，每帧返回应执行的步数。
+ *
+ * 慢帧之后会在后续帧中补步，但每帧最多执行 maxStepsPerFrame 步；超出预算的积压被丢弃，
+ * 以免模拟越追越慢。同时统计最近约一秒内模拟时间与真实时间之比。
+ */
+class SubstepScheduler
+{
+public:
+	/**
+	 * @param _stepTime 每个模拟步对应的真实时间（秒）。
+	 * @param _maxStepsPerFrame 每帧最多执行的步数，至少为 1。
+	 */
+	SubstepScheduler(double _stepTime, unsigned _maxStepsPerFrame);
+
+	/**
+	 * @brief 记入一帧的时间并取出本帧要执行的步数。
+	 * @param delta 本帧经过的真实时间（秒）。
+	 * @return 本帧应执行的模拟步数，可能为 0。
+	 */
+	unsigned BeginFrame(double delta);
+
+	/**
+	 * @brief 记录一个已执行的模拟步推进的模拟时间，用于计算速度比。
+	 */
+	void RecordStep(double simulatedTime);
+
+	/**
+	 * @brief 最近一个统计窗口内模拟时间与真实时间之比，尚无完整窗口时为 0。
+	 */
+	double SimulatedToRealRatio() const
+	{
+		return ratio;
+	}
+
+	/**
+	 * @brief 因超出每帧预算而被丢弃的累计真实时间（秒）。
+	 */
+	double DroppedTime() const
+	{
+		return droppedTime;
+	}
+
+	/**
+	 * @brief 上一次 BeginFrame 是否因预算不足丢弃了积压。
+	 */
+	bool FellBehind() const
+	{
+		return fellBehind;
+	}
+
+	void SetStepTime(double newStepTime)
+	{
+		stepTime = newStepTime;
+	}
+
+	double GetStepTime() const
+	{
+		return stepTime;
+	}
+
+	void SetMaxStepsPerFrame(unsigned steps)
+	{
+		maxStepsPerFrame = steps > 0 ? steps : 1;
+	}
+
+	unsigned GetMaxStepsPerFrame() const
+	{
+		return maxStepsPerFrame;
+	}
+
+private:
+	double stepTime;
+	unsigned maxStepsPerFrame;
+
+	// 尚未执行的真实时间
+	double backlog;
+	double droppedTime;
+	bool fellBehind;
+
+	// 当前统计窗口内的累计量
+	double windowReal;
+	double windowSimulated;
+	double ratio;
+};
+
+#endif //SUBSTEP_SCHEDULER_H
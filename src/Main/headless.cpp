@@ -0,0 +1,444 @@
+/**
+ * @file headless.cpp
+ * @brief 无窗口、无 OpenGL 上下文的模拟入口：在 CPU 后端上推进 N 步并写出最终状态。
+ */
+
+#include "../SPHSimulation/CPUSimulation.hpp"
+#include "../SPHSimulation/SimulationConfig.hpp"
+#include "../SPHSimulation/AdaptiveTimestep.hpp"
+#include "../SPHSimulation/DistanceField.hpp"
+#include "../SPHSimulation/SPHConstants.hpp"
+
+#include "../Helper/ThreadPool.hpp"
+
+#include "../Log/Logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+/**
+ * @brief 命令行参数，默认值与 SPHWaterScene 一致。
+ */
+struct HeadlessOptions
+{
+	unsigned steps = 600;
+	float dt = 0.016666666666f / 2;
+
+	SimulationConfig simulation;
+
+	std::string output = "sph_state.txt";
+
+	// 大于 0 时不做普通模拟，改为对每种积分方式求能稳定模拟这么长时间的最大固定步长，
+	// 以状态方程为基准，-pressure pcisph 时再对 PCISPH 求一遍
+	float stabilityDuration = 0;
+
+	// 大于 0 时在模拟结束后提取边缘粒子，用该边长的纹理比较跳跃泛洪与逐粒子生成的距离场
+	unsigned distanceFieldSize = 0;
+};
+
+// 粒子速率超过该值（约为从盒顶自由落到盒底速度的 4 倍）即视为发散
+constexpr float UnstableSpeed = 25.0f;
+
+// 稳定性测试从该步长开始加倍，再在最后稳定与首个发散的步长之间二分
+constexpr float StabilityStartDt = 0.016666666666f / 16;
+constexpr float StabilityMaxDt = 0.1f;
+constexpr unsigned StabilityBisections = 4;
+
+/**
+ * @brief 一次稳定性模拟的结果，PCISPH 时附带每步迭代次数与迭代结束时的密度误差统计。
+ */
+struct StabilityRun
+{
+	bool stable = false;
+	unsigned steps = 0;
+	// 所有步中最大密度超出静止密度的相对值，两种压强求解方式可直接比较
+	float peakCompression = 0;
+	float meanIterations = 0;
+	float medianDensityError = 0;
+	float maxDensityError = 0;
+	unsigned stepsAboveTolerance = 0;
+};
+
+void PrintUsage(const char* name)
+{
+	std::cout <<
+		"Usage: " << name << " [options]\n"
+		"  -n <steps>          number of solver steps (default 600)\n"
+		"  -dt <seconds>       integrator time step without -cfl (default 1/120)\n"
+		"  -o <file>           final state output (default sph_state.txt)\n"
+		"  -stability <seconds> report each integrator's largest stable fixed dt instead, for eos and\n"
+		"                      with -pressure pcisph also for pcisph\n"
+		"  -distancefield <size> validate the jump flood distance field against per-particle splats\n"
+		"  -d                  debug logging\n" <<
+		SimulationConfig::Usage();
+}
+
+bool ParseOptions(int argc, char* args[], HeadlessOptions& options)
+{
+	for(int i = 1; i < argc; ++i)
+	{
+		const std::string arg(args[i]);
+		const int remaining = argc - i - 1;
+
+		if(arg == "-n" && remaining >= 1)
+			options.steps = std::strtoul(args[++i], nullptr, 10);
+		else if(arg == "-dt" && remaining >= 1)
+			options.dt = std::strtof(args[++i], nullptr);
+		else if(arg == "-o" && remaining >= 1)
+			options.output = args[++i];
+		else if(arg == "-stability" && remaining >= 1)
+			options.stabilityDuration = std::strtof(args[++i], nullptr);
+		else if(arg == "-distancefield" && remaining >= 1)
+			options.distanceFieldSize = std::strtoul(args[++i], nullptr, 10);
+		else if(arg == "-d")
+			Logging::Settings::SetLevel(Logging::Level::Debug);
+		else if(!options.simulation.ParseArgument(i, argc, args))
+		{
+			Logger::Error() << "Unknown or incomplete argument: " << arg << '\n';
+			return false;
+		}
+	}
+
+	//Headless always runs on the CPU, -cpu is accepted for symmetry with the windowed build
+	options.simulation.backend = SimulationBackend::Type::CPU;
+
+	return options.simulation.Validate();
+}
+
+/**
+ * @brief 以文本形式写出每个粒子的位置、速度、密度与压强，每行一个粒子。
+ */
+bool WriteState(const CPUSimulationState& state, const std::string& fileName)
+{
+	std::ofstream out(fileName);
+	if(!out.is_open())
+	{
+		Logger::Error() << "Couldn't open output file " << fileName << '\n';
+		return false;
+	}
+
+	out << "# particles " << state.ParticleCount() << '\n';
+	out << "# x y z vx vy vz density pressure\n";
+
+	const auto& positions = state.Positions();
+	const auto& velocities = state.Velocities();
+	for(unsigned i = 0; i < state.ParticleCount(); ++i)
+	{
+		out <<
+			positions[i].x << ' ' << positions[i].y << ' ' << positions[i].z << ' ' <<
+			velocities[i].x << ' ' << velocities[i].y << ' ' << velocities[i].z << ' ' <<
+			state.Densities()[i] << ' ' << state.Pressures()[i] << '\n';
+	}
+
+	return static_cast<bool>(out);
+}
+
+/**
+ * @brief 从初始状态以固定步长模拟 duration 秒，粒子速率始终有限且不超过 UnstableSpeed 时视为稳定。
+ */
+StabilityRun RunsStable(const SimulationConfig& config, Integrator integrator, float dt, float duration)
+{
+	CPUSimulation simulation(config);
+
+	StepParams params;
+	params.dt = dt;
+	params.gravityDir = glm::vec3(0, -1, 0);
+	params.integrator = integrator;
+	params.obstacleEnabled = false;
+	params.obstacleRadius = 0;
+
+	StabilityRun run;
+	unsigned iterations = 0;
+	std::vector<float> densityErrors;
+
+	const unsigned steps = static_cast<unsigned>(std::ceil(duration / dt));
+	for(unsigned step = 0; step < steps; ++step)
+	{
+		simulation.Step(params);
+
+		iterations += simulation.PressureIterations();
+		densityErrors.push_back(simulation.DensityError());
+
+		const std::vector<float>& densities = simulation.State().Densities();
+		const float maxDensity = *std::max_element(densities.begin(), densities.end());
+		run.peakCompression = std::max(run.peakCompression, maxDensity / SPH::RestDensity - 1);
+
+		const float speed = simulation.MaxSpeed();
+		if(!std::isfinite(speed) || speed > UnstableSpeed)
+			return run;
+	}
+
+	run.stable = true;
+	run.steps = steps;
+	run.meanIterations = static_cast<float>(iterations) / steps;
+
+	std::sort(densityErrors.begin(), densityErrors.end());
+	run.medianDensityError = densityErrors[steps / 2];
+	run.maxDensityError = densityErrors.back();
+	run.stepsAboveTolerance = static_cast<unsigned>(densityErrors.end() -
+		std::upper_bound(densityErrors.begin(), densityErrors.end(), config.densityTolerance));
+
+	return run;
+}
+
+/**
+ * @brief 输出一次稳定模拟的压缩量，PCISPH 时再输出迭代次数与迭代结束时的密度误差。
+ */
+void PrintRun(const SimulationConfig& config, const StabilityRun& run)
+{
+	std::cout << ", peak density " << 100 * run.peakCompression << "% above rest";
+	if(config.pressureSolver != PressureSolver::Predictive)
+		return;
+
+	std::cout <<
+		", " << run.meanIterations << " iterations per step, density error after the last iteration " <<
+		100 * run.medianDensityError << "% median, " << 100 * run.maxDensityError << "% max, " <<
+		run.stepsAboveTolerance << " of " << run.steps << " steps above tolerance";
+}
+
+/**
+ * @brief 步长加倍直到发散，再二分求出最大稳定步长，连最小步长都不稳定时返回 0。
+ */
+float LargestStableDt(const SimulationConfig& config, Integrator integrator, float duration)
+{
+	const auto report = [&config](float dt, const StabilityRun& run)
+	{
+		std::cout << "  dt " << dt << " s: " << (run.stable ? "stable" : "unstable");
+		if(run.stable)
+		{
+			PrintRun(config, run);
+		}
+		std::cout << std::endl;
+		return run.stable;
+	};
+
+	float stable = 0;
+	float unstable = StabilityStartDt;
+	while(unstable <= StabilityMaxDt && report(unstable, RunsStable(config, integrator, unstable, duration)))
+	{
+		stable = unstable;
+		unstable *= 2;
+	}
+
+	if(stable == 0 || unstable > StabilityMaxDt)
+		return stable;
+
+	for(unsigned i = 0; i < StabilityBisections; ++i)
+	{
+		const float dt = (stable + unstable) / 2;
+		if(report(dt, RunsStable(config, integrator, dt, duration)))
+			stable = dt;
+		else
+			unstable = dt;
+	}
+
+	return stable;
+}
+
+int RunStabilityBenchmark(const HeadlessOptions& options)
+{
+	std::cout <<
+		"Largest stable fixed dt over " << options.stabilityDuration << " s for " <<
+		options.simulation.ParticleCount() << " particles\n";
+
+	const std::pair<Integrator, const char*> integrators[] =
+	{
+		{ Integrator::SymplecticEuler, "Symplectic Euler" },
+		{ Integrator::Leapfrog, "Leapfrog" },
+	};
+
+	//The equation of state is always measured as the baseline PCISPH is compared against
+	SimulationConfig eos = options.simulation;
+	eos.pressureSolver = PressureSolver::EquationOfState;
+
+	for(const auto& [integrator, name] : integrators)
+	{
+		std::cout << "EOS, " << name << '\n';
+		const float eosDt = LargestStableDt(eos, integrator, options.stabilityDuration);
+		std::cout << "EOS, " << name << ": largest stable dt " << eosDt << " s";
+		if(eosDt > 0)
+		{
+			std::cout << ", " << 1 / eosDt << " steps per simulated second";
+		}
+		std::cout << '\n';
+
+		if(options.simulation.pressureSolver != PressureSolver::Predictive)
+			continue;
+
+		//Not diverging doesn't mean converged, the per dt lines above show where the iterations keep up
+		std::cout << "PCISPH, " << name << '\n';
+		const float dt = LargestStableDt(options.simulation, integrator, options.stabilityDuration);
+		std::cout << "PCISPH, " << name << ": largest stable dt " << dt << " s";
+		if(dt > 0)
+		{
+			std::cout << ", " << 1 / dt << " steps per simulated second";
+			if(eosDt > 0)
+			{
+				std::cout << ", " << dt / eosDt << "x EOS";
+			}
+		}
+		std::cout << '\n';
+	}
+
+	return 0;
+}
+
+/**
+ * @brief 用最终状态的边缘粒子分别以跳跃泛洪与逐粒子方式生成距离场，输出耗时与两者的差异。
+ */
+void ValidateDistanceField(CPUSimulation& simulation, const SimulationConfig& config, unsigned size)
+{
+	simulation.ExtractEdges();
+	const std::vector<glm::vec3>& edges = simulation.State().EdgePositions();
+
+	ThreadPool pool(config.threads > 0 ? config.threads : std::thread::hardware_concurrency());
+
+	const auto splatStart = std::chrono::steady_clock::now();
+	const std::vector<float> reference = SPH::SplatDistanceField(edges, size);
+	const auto floodStart = std::chrono::steady_clock::now();
+	const std::vector<float> flooded = SPH::JumpFloodDistanceField(edges, size, pool);
+	const auto floodEnd = std::chrono::steady_clock::now();
+
+	//Voxels near the cutoff can fall on different sides of it, those are counted apart from the distance error
+	float maxError = 0;
+	std::size_t mismatched = 0;
+	std::size_t cutoffFlips = 0;
+	for(std::size_t i = 0; i < reference.size(); ++i)
+	{
+		if((flooded[i] < 1.0f) != (reference[i] < 1.0f))
+		{
+			++cutoffFlips;
+			continue;
+		}
+
+		const float error = std::abs(flooded[i] - reference[i]);
+		maxError = std::max(maxError, error);
+		if(error > 1e-6f)
+			++mismatched;
+	}
+
+	std::cout <<
+		"Distance field " << size << "^3 from " << edges.size() << " edge particles\n" <<
+		"  splat (1 thread): " << std::chrono::duration<double, std::milli>(floodStart - splatStart).count() << " ms\n" <<
+		"  jump flood (" << pool.Size() << " threads): " <<
+		std::chrono::duration<double, std::milli>(floodEnd - floodStart).count() << " ms, " <<
+		"first step " << SPH::JumpFloodFirstStep(size) << '\n' <<
+		"  voxels differing: " << mismatched << " of " << reference.size() << ", largest difference " << maxError <<
+		" (" << maxError * size << " voxels)\n" <<
+		"  voxels on different sides of the " << SPH::DistanceFieldMaxRadius << " cutoff: " << cutoffFlips << '\n';
+
+	//Blocks raycast.frag skips whole: minimum above the 0.03 shell plus a margin of two voxels
+	const std::vector<std::vector<float>> levels = SPH::MinReduceDistanceField(flooded, size);
+	const float emptyAbove = 0.03f + 2.0f / size;
+	for(std::size_t level = 1; level < levels.size(); ++level)
+	{
+		const std::size_t empty = std::count_if(levels[level].begin(), levels[level].end(),
+			[emptyAbove](float distance) { return distance > emptyAbove; });
+		std::cout <<
+			"  level " << level << " (" << (1u << level) << "^3 voxel blocks): " << empty << " of " << levels[level].size() <<
+			" empty\n";
+	}
+}
+
+} //unnamed namespace
+
+int main(int argc, char* args[])
+{
+	Logging::Settings::SetLevel(Logging::Level::Error);
+
+	HeadlessOptions options;
+	if(!ParseOptions(argc, args, options))
+	{
+		PrintUsage(args[0]);
+		return 1;
+	}
+
+	if(options.stabilityDuration > 0)
+		return RunStabilityBenchmark(options);
+
+	CPUSimulation simulation(options.simulation);
+
+	StepParams params;
+	params.dt = options.dt;
+	params.gravityDir = glm::vec3(0, -1, 0);
+	params.integrator = options.simulation.integrator;
+	params.obstacleEnabled = false;
+	params.obstacleRadius = 0;
+
+	std::cout <<
+		"Simulating " << simulation.State().ParticleCount() << " particles on " <<
+		simulation.ThreadCount() << " threads for " << options.steps << " steps\n";
+
+	const auto start = std::chrono::steady_clock::now();
+
+	const SimulationConfig& config = options.simulation;
+	SPH::AdaptiveTimestep timestep(config.courantNumber, config.minTimestep, config.maxTimestep);
+
+	double simulated = 0;
+	unsigned long long pressureIterations = 0;
+	float smallestDt = params.dt;
+	float largestDt = params.dt;
+
+	for(unsigned step = 0; step < options.steps; ++step)
+	{
+		//The CPU backend's speed is exact, so the CFL step is chosen before every step
+		if(config.UsesAdaptiveTimestep())
+		{
+			params.dt = timestep.Next(simulation.MaxSpeed());
+			smallestDt = step == 0 ? params.dt : std::min(smallestDt, params.dt);
+			largestDt = step == 0 ? params.dt : std::max(largestDt, params.dt);
+		}
+
+		simulation.Step(params);
+		simulated += params.dt;
+		pressureIterations += simulation.PressureIterations();
+	}
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout <<
+		"Wall time: " << seconds << " s, " <<
+		(seconds > 0 ? options.steps / seconds : 0.0) << " steps/s, " <<
+		simulated << " s simulated\n";
+
+	if(config.UsesAdaptiveTimestep())
+	{
+		std::cout << "Adaptive dt between " << smallestDt << " and " << largestDt << " s\n";
+	}
+
+	if(config.pressureSolver == PressureSolver::Predictive)
+	{
+		std::cout <<
+			"Pressure iterations: " << (options.steps > 0 ? double(pressureIterations) / options.steps : 0.0) <<
+			" per step, last density error " << simulation.DensityError() * 100 << "%\n";
+	}
+
+	if(options.simulation.UsesNeighbourLists())
+	{
+		std::cout <<
+			"Neighbour lists rebuilt " << simulation.NeighbourListBuilds() << " times, " <<
+			simulation.TruncatedNeighbourLists() << " truncated on the last rebuild\n";
+	}
+
+	if(options.distanceFieldSize > 0)
+	{
+		ValidateDistanceField(simulation, config, options.distanceFieldSize);
+	}
+
+	if(!WriteState(simulation.State(), options.output))
+		return 1;
+
+	std::cout << "Final state written to " << options.output << '\n';
+
+	return 0;
+}
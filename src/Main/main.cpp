@@ -7,23 +7,37 @@
 
 #include <SDL2/SDL_main.h>
 
+#include <iostream>
+
 #include "../Log/Logger.h"
 
 /**
- * @brief 程序入口函数，根据命令行参数设置日志等级并运行游戏。
+ * @brief 程序入口函数，根据命令行参数设置日志等级与模拟后端并运行游戏。
  * @param argc 命令行参数数量。
  * @param args 命令行参数数组。
  * @return 程序退出码，正常运行返回 0。
  */
 int main(int argc, char* args[])
 {
+	Logging::Settings::SetLevel(Logging::Level::Error);
+	SimulationConfig config;
+
+	for(int i = 1; i < argc; ++i)
+	{
+		const std::string arg(args[i]);
+		if(arg == "-d")
+			Logging::Settings::SetLevel(Logging::Level::Debug);
+		else if(!config.ParseArgument(i, argc, args))
+		{
+			std::cerr << "Unknown argument " << arg << "\nOptions:\n  -d                  debug logging\n" << SimulationConfig::Usage();
+			return 1;
+		}
+	}
 
-	if(argc > 1 && std::string(args[1]) == "-d")
-		Logging::Settings::SetLevel(Logging::Level::Debug);
-	else
-		Logging::Settings::SetLevel(Logging::Level::Error);
+	if(!config.Validate())
+		return 1;
 
-	Game game;
+	Game game(config);
 	game.Run();
 
 	return 0;
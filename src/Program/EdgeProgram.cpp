@@ -0,0 +1,95 @@
+#include "EdgeProgram.hpp"
+
+#include "SimulationProgram.hpp"
+#include "../SPHSimulation/SimulationState.hpp"
+#include "../Log/Logger.h"
+
+namespace
+{
+
+constexpr const char* positionBufferName = "positionBuffer";
+constexpr const char* gridBufferName = "gridBuffer";
+constexpr const char* cellKeyBufferName = "cellKeyBuffer";
+constexpr const char* neighbourCountBufferName = "neighbourCountBuffer";
+constexpr const char* neighbourListBufferName = "neighbourListBuffer";
+constexpr const char* edgeBufferName = "edgeBuffer";
+constexpr const char* edgeDispatchBufferName = "edgeDispatchBuffer";
+
+constexpr const char* extractSource = "../shaders/Simulation/edgeExtract.comp";
+constexpr const char* argumentsSource = "../shaders/Simulation/edgeDispatch.comp";
+
+//One thread per particle, the particle count is a multiple of 4 * 4 * 4
+constexpr unsigned groupSize = 64;
+
+bool CompileProgram(GL::Program& program, const char* source, const SimulationState& state, bool neighbourLists)
+{
+	GL::Shader shader(GL_COMPUTE_SHADER);
+	state.DefineConstants(shader);
+	if(neighbourLists)
+	{
+		shader.Define("NEIGHBOUR_LISTS");
+	}
+
+	if(!shader.FromFile(source))
+	{
+		Logger::Error() << "Shader compilation [" << source <<"] failed with message: " << shader.GetInfoLog() << '\n';
+		return false;
+	}
+
+	program.AttachShader(shader);
+	if(!program.Link())
+	{
+		Logger::Error() << "Shader linking failed with message: " << program.GetInfoLog() << '\n';
+		return false;
+	}
+
+	return true;
+}
+
+} //unnamed namespace
+
+EdgeProgram::EdgeProgram(SimulationState& _state, const SimulationProgram& simulation) :
+	state(_state)
+{
+	CompileShaders();
+
+	if(state.UsesNeighbourLists())
+	{
+		state.AttachNeighbourCounts(extract, neighbourCountBufferName);
+		state.AttachNeighbourLists(extract, neighbourListBufferName);
+	}
+	else
+	{
+		state.AttachGrid(extract, gridBufferName);
+		state.AttachCellKeys(extract, cellKeyBufferName);
+	}
+	state.AttachEdge(extract, edgeBufferName);
+
+	state.AttachEdge(arguments, edgeBufferName);
+	state.AttachEdgeDispatch(arguments, edgeDispatchBufferName);
+
+	simulation.AttachKernelParams(extract);
+}
+
+void EdgeProgram::CompileShaders()
+{
+	//The grid is only rebuilt together with the lists, so it can be far behind the particles
+	CompileProgram(extract, extractSource, state, state.UsesNeighbourLists());
+	CompileProgram(arguments, argumentsSource, state, false);
+}
+
+void EdgeProgram::Run()
+{
+	state.ResetEdgeCount();
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	extract.Use();
+	state.AttachPosition(extract, positionBufferName);
+
+	glDispatchCompute(state.ParticleCount() / groupSize, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	arguments.Use();
+	glDispatchCompute(1, 1, 1);
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+}
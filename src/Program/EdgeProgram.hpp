@@ -0,0 +1,35 @@
+#ifndef EDGE_PROGRAM_HPP
+#define EDGE_PROGRAM_HPP
+
+#include "../Helper/Program.hpp"
+
+class SimulationState;
+class SimulationProgram;
+
+/**
+ * @brief 按需提取表面粒子写入 SimulationState 的边缘缓冲，供距离场与边缘点渲染使用。
+ *
+ * 与模拟步分离，只在渲染需要表面时运行，每帧至多一次。启用邻居表时遍历邻居表，
+ * 否则遍历最近一次排序得到的网格；每个工作组先在共享内存中计数，再用一次全局原子操作占位。
+ * 边缘粒子数只留在 GPU 上，距离场与边缘点渲染通过间接参数使用它。
+ */
+class EdgeProgram
+{
+private:
+	SimulationState& state;
+
+	GL::Program extract;
+	// 由边缘粒子数写入 SimulationState::EdgeDispatchBuffer 的间接参数
+	GL::Program arguments;
+
+	void CompileShaders();
+public:
+	EdgeProgram(SimulationState& _state, const SimulationProgram& simulation);
+
+	/**
+	 * @brief 重新提取边缘粒子并更新间接参数，须在最近一步模拟之后调用。
+	 */
+	void Run();
+};
+
+#endif //EDGE_PROGRAM_HPP
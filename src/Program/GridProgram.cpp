@@ -11,33 +11,44 @@ constexpr const char* positionBufferName = "positionBuffer";
 constexpr const char* velocityBufferName = "velocityBuffer";
 constexpr const char* positionNewBufferName = "positionNewBuffer";
 constexpr const char* velocityNewBufferName = "velocityNewBuffer";
-constexpr const char* superBlockBufferName = "superBlockBuffer";
+constexpr const char* pressureBufferName = "pressureBuffer";
+constexpr const char* previousPressureBufferName = "previousPressureBuffer";
+constexpr const char* activeCellBufferName = "activeCellBuffer";
+constexpr const char* cellDispatchBufferName = "cellDispatchBuffer";
+constexpr const char* cellKeyBufferName = "cellKeyBuffer";
+constexpr const char* scanBufferName = "scanBuffer";
+constexpr const char* scanStateBufferName = "scanStateBuffer";
 
 GridProgram::GridProgram(SimulationState& _state) :
-	state(_state)
+	state(_state),
+	scanPartitionCapacity(0)
 {
 	CompileShaders();
 
 	state.AttachParticleIndex(count, indexBufferName);
 	state.AttachGrid(count, gridBufferName);
+	state.AttachCellKeys(count, cellKeyBufferName);
 	//state.AttachPosition(count, positionBufferName);
 
-	state.AttachGrid(offset, gridBufferName);
-	state.AttachSuperBlock(offset, superBlockBufferName);
-
-	state.AttachSuperBlock(superBlock, superBlockBufferName);
-
-	state.AttachGrid(finalize, gridBufferName);
-	state.AttachSuperBlock(finalize, superBlockBufferName);
+	scanStorage.AttachToBlock(scan, scan.GetShaderStorageBlockIndex(scanBufferName));
+	scanStateStorage.AttachToBlock(scan, scan.GetShaderStorageBlockIndex(scanStateBufferName));
 
 	state.AttachGrid(scatter, gridBufferName);
 	state.AttachParticleIndex(scatter, indexBufferName);
+	if(state.UsesPredictivePressure())
+	{
+		state.AttachPressure(scatter, pressureBufferName);
+		state.AttachPreviousPressure(scatter, previousPressureBufferName);
+	}
+
+	state.AttachGrid(compact, gridBufferName);
+	state.AttachActiveCells(compact, activeCellBufferName);
+	state.AttachCellDispatch(compact, cellDispatchBufferName);
 
 }
 
-bool CompileProgram(GL::Program& program, const char* source)
+bool CompileProgram(GL::Program& program, GL::Shader& shader, const char* source)
 {
-	GL::Shader shader(GL_COMPUTE_SHADER);
 	if(!shader.FromFile(source))
 	{
 		Logger::Error() << "Shader compilation [" << source <<"] failed with message: " << shader.GetInfoLog() << '\n';
@@ -54,54 +65,84 @@ bool CompileProgram(GL::Program& program, const char* source)
 	return true;
 }
 
+bool CompileProgram(GL::Program& program, const char* source, const SimulationState& state)
+{
+	GL::Shader shader(GL_COMPUTE_SHADER);
+	state.DefineConstants(shader);
+
+	return CompileProgram(program, shader, source);
+}
+
 void GridProgram::CompileShaders()
 {
-	CompileProgram(count, countSource);
+	CompileProgram(count, countSource, state);
+
+	GL::Shader scanShader(GL_COMPUTE_SHADER);
+	scanShader.Define("SCAN_WORKGROUP_SIZE", scanWorkGroupSize);
+	scanShader.Define("SCAN_ELEMENTS_PER_THREAD", scanElementsPerThread);
+	CompileProgram(scan, scanShader, scanSource);
+
+	//PCISPH starts each step from the previous pressure, which has to follow the particles
+	GL::Shader scatterShader(GL_COMPUTE_SHADER);
+	state.DefineConstants(scatterShader);
+	if(state.UsesPredictivePressure())
+	{
+		scatterShader.Define("PERMUTE_PRESSURE");
+	}
+	CompileProgram(scatter, scatterShader, scatterSource);
+
+	CompileProgram(compact, compactSource, state);
+}
+
+void GridProgram::ExclusiveScan(const GL::Buffer& buffer, GLuint count)
+{
+	const GLuint partitions = (count + scanPartitionSize - 1) / scanPartitionSize;
+	if(partitions == 0)
+		return;
 
-	CompileProgram(offset, offsetSource);
+	//Partition counter followed by one flag/value word per partition
+	if(partitions > scanPartitionCapacity)
+	{
+		scanStateBuffer.InitEmpty((partitions + 1) * sizeof(GLuint), GL_DYNAMIC_COPY);
+		scanStateStorage.AttachBuffer(scanStateBuffer);
+		scanPartitionCapacity = partitions;
+	}
 
-	CompileProgram(superBlock, superBlockSource);
+	glClearNamedBufferSubData(scanStateBuffer.GetId(), GL_R32UI, 0, (partitions + 1) * sizeof(GLuint), GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+	scanStorage.AttachBuffer(buffer);
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
 
-	CompileProgram(finalize, finalizeSource);
+	scan.Use();
+	glUniform1ui(0, count);
+	glDispatchCompute(partitions, 1, 1);
 
-	CompileProgram(scatter, scatterSource);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 }
 
 void GridProgram::Run()
 {
 	glClearNamedBufferData(	state.GridBuffer().GetId(), GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+	state.ResetCellKeys();
 	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
 
 	count.Use();
 	state.AttachPosition(count, positionBufferName);
-	glUniform1ui(0, state.GridRes());
 	glDispatchCompute(state.ResX() / 4, state.ResY() / 4, state.ResZ() / 4);
 
 	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 
 	//glFinish();
 
-	offset.Use();
-	//const unsigned l = state.GridRes() / 4;
-	glDispatchCompute(1, 1, 1);
-
-	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	ExclusiveScan(state.GridBuffer(), state.CellSlotCount());
 
 	//glFinish();
 
-	superBlock.Use();
-	//glUniform1ui(0, l * l * l * 64 / 1024);
-	glDispatchCompute(1, 1, 1);
-	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
-
-	//glFinish();
-
-	finalize.Use();
-	glDispatchCompute(state.GridRes() * state.GridRes() * state.GridRes() / 200, 1, 1);
-
-	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	state.ResetCellDispatch();
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
 
-	//glFinish();
+	//Independent of scatter, both only read the offsets; the barrier below covers both
+	compact.Use();
+	glDispatchCompute((state.CellSlotCount() + 63) / 64, 1, 1);
 
 	scatter.Use();
 	state.AttachPosition(scatter, positionBufferName);
@@ -109,7 +150,7 @@ void GridProgram::Run()
 	state.AttachVelocity(scatter, velocityBufferName);
 	state.AttachVelocityBack(scatter, velocityNewBufferName);
 	glDispatchCompute(state.ResX() / 4, state.ResY() / 4, state.ResZ() / 4);
-	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
 
 	//glFinish();
 
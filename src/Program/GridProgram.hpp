@@ -2,6 +2,8 @@
 #define GRID_PROGRAM_HPP
 
 #include "../Helper/Program.hpp"
+#include "../Helper/Buffer.hpp"
+#include "../Helper/ShaderStorage.hpp"
 
 class SimulationState;
 
@@ -11,21 +13,33 @@ private:
 	SimulationState& state;
 
 	GL::Program count;
-	GL::Program offset;
-	GL::Program superBlock;
-	GL::Program finalize;
+	GL::Program scan;
 	GL::Program scatter;
+	GL::Program compact;
+
+	GL::ShaderStorage scanStorage;
+	GL::ShaderStorage scanStateStorage;
+	GL::Buffer scanStateBuffer;
+	GLuint scanPartitionCapacity;
 
 	void CompileShaders();
 
 	static constexpr const char* countSource = "../shaders/Grid/count.comp";
-	static constexpr const char* offsetSource = "../shaders/Grid/offset.comp";
-	static constexpr const char* superBlockSource = "../shaders/Grid/superBlock.comp";
+	static constexpr const char* scanSource = "../shaders/Grid/scan.comp";
 	static constexpr const char* scatterSource = "../shaders/Grid/scatter.comp";
-	static constexpr const char* finalizeSource = "../shaders/Grid/finalize.comp";
+	static constexpr const char* compactSource = "../shaders/Grid/compact.comp";
+
+	static constexpr GLuint scanWorkGroupSize = 256;
+	static constexpr GLuint scanElementsPerThread = 4;
+	static constexpr GLuint scanPartitionSize = scanWorkGroupSize * scanElementsPerThread;
 public:
 	GridProgram(SimulationState& _state);
 
+	/**
+	 * @brief In place exclusive prefix sum over the first count uints of buffer, in a single dispatch.
+	 */
+	void ExclusiveScan(const GL::Buffer& buffer, GLuint count);
+
 	void Run();
 };
 
@@ -0,0 +1,93 @@
+#include "IntegratorProgram.hpp"
+
+#include "../SPHSimulation/SimulationState.hpp"
+
+#include <cstring>
+
+namespace
+{
+
+constexpr const char* positionBufferName = "positionBuffer";
+constexpr const char* velocityBufferName = "velocityBuffer";
+constexpr const char* densityBufferName = "densityBuffer";
+constexpr const char* forceBufferName = "forceBuffer";
+constexpr const char* maxSpeedBufferName = "maxSpeedBuffer";
+
+constexpr const unsigned DtLocation = 0;
+constexpr const unsigned GravityLocation = 1;
+constexpr const unsigned ObstacleEnabledLocation = 2;
+constexpr const unsigned ObstacleRadiusLocation = 3;
+constexpr const unsigned KickDtLocation = 4;
+
+constexpr unsigned groupX = 4;
+constexpr unsigned groupY = 4;
+constexpr unsigned groupZ = 4;
+
+} //unnamed namespace
+
+IntegratorProgram::IntegratorProgram(SimulationState& _state) :
+	state(_state),
+	speedReadback(sizeof(GLuint)),
+	previousDt(0)
+{
+	CompileShaders();
+
+	state.AttachForce(integrate, forceBufferName);
+	state.AttachDensity(integrate, densityBufferName);
+	state.AttachMaxSpeed(integrate, maxSpeedBufferName);
+}
+
+void IntegratorProgram::CompileShaders()
+{
+	GL::Shader shader(GL_COMPUTE_SHADER);
+	state.DefineConstants(shader);
+	if(!shader.FromFile(integrateSource))
+	{
+		Logger::Error() << "Integrator shader compilation failed: " << shader.GetInfoLog() << '\n';
+		return;
+	}
+
+	integrate.AttachShader(shader);
+	if(!integrate.Link())
+	{
+		Logger::Error() << "Integrator program linking failed: " << integrate.GetInfoLog() << '\n';
+	}
+}
+
+void IntegratorProgram::Run(float dt, const glm::vec3& gravityDir, Integrator integrator, bool obstacleEnabled, float obstacleRadius)
+{
+	state.ResetMaxSpeed();
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	integrate.Use();
+	state.AttachPosition(integrate, positionBufferName);
+	state.AttachVelocity(integrate, velocityBufferName);
+
+	glUniform1f(DtLocation, dt);
+	glUniform3fv(GravityLocation, 1, reinterpret_cast<const GLfloat*>(&gravityDir[0]));
+
+	// Provide rigid obstacle toggle and radius to integrator
+	glUniform1i(ObstacleEnabledLocation, obstacleEnabled ? 1 : 0);
+	glUniform1f(ObstacleRadiusLocation, obstacleRadius);
+
+	//Leapfrog starts with a half kick, also after switching over from Euler
+	const bool leapfrog = integrator == Integrator::Leapfrog;
+	glUniform1f(KickDtLocation, leapfrog ? 0.5f * (previousDt + dt) : dt);
+	previousDt = leapfrog ? dt : 0.0f;
+
+	glDispatchCompute(state.ResX() / groupX, state.ResY() / groupY, state.ResZ() / groupZ);
+
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	speedReadback.Capture(state.MaxSpeedBuffer(), 0);
+}
+
+float IntegratorProgram::MaxSpeed()
+{
+	speedReadback.Poll();
+	const GLuint bits = speedReadback.Latest<GLuint>();
+
+	float speed;
+	std::memcpy(&speed, &bits, sizeof(speed));
+	return speed;
+}
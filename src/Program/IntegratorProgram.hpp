@@ -0,0 +1,38 @@
+#ifndef INTEGRATOR_PROGRAM_HPP
+#define INTEGRATOR_PROGRAM_HPP
+
+#include "../Helper/Program.hpp"
+#include "../Helper/ReadbackRing.hpp"
+#include "../SPHSimulation/SimulationBackend.hpp"
+
+#include <glm/vec3.hpp>
+
+class SimulationState;
+
+class IntegratorProgram
+{
+private:
+	SimulationState& state;
+
+	GL::Program integrate;
+
+	GL::ReadbackRing speedReadback;
+
+	// 上一个蛙跳步的步长，上一步不是蛙跳时为 0
+	float previousDt;
+
+	void CompileShaders();
+
+	static constexpr const char* integrateSource = "../shaders/basic.comp";
+public:
+	IntegratorProgram(SimulationState& _state);
+
+	void Run(float dt, const glm::vec3& gravityDir, Integrator integrator, bool obstacleEnabled, float obstacleRadius);
+
+	/**
+	 * @brief 最近一次已回读的粒子最大速率，不会等待 GPU，因此落后若干步。
+	 */
+	float MaxSpeed();
+};
+
+#endif //INTEGRATOR_PROGRAM_HPP
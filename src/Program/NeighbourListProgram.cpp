@@ -0,0 +1,171 @@
+#include "NeighbourListProgram.hpp"
+
+#include "SimulationProgram.hpp"
+#include "../SPHSimulation/SimulationState.hpp"
+#include "../Log/Logger.h"
+
+#include <cstring>
+
+namespace
+{
+
+constexpr const char* positionBufferName = "positionBuffer";
+constexpr const char* velocityBufferName = "velocityBuffer";
+constexpr const char* densityBufferName = "densityBuffer";
+constexpr const char* pressureBufferName = "pressureBuffer";
+constexpr const char* forceBufferName = "forceBuffer";
+constexpr const char* gridBufferName = "gridBuffer";
+constexpr const char* cellKeyBufferName = "cellKeyBuffer";
+constexpr const char* referencePositionBufferName = "referencePositionBuffer";
+constexpr const char* neighbourCountBufferName = "neighbourCountBuffer";
+constexpr const char* neighbourListBufferName = "neighbourListBuffer";
+constexpr const char* neighbourStateBufferName = "neighbourStateBuffer";
+
+constexpr const char* buildSource = "../shaders/Simulation/neighbourBuild.comp";
+constexpr const char* densitySource = "../shaders/Simulation/neighbourDensity.comp";
+constexpr const char* forceSource = "../shaders/Simulation/neighbourForce.comp";
+
+constexpr const unsigned SkinLocation = 0;
+
+//One thread per particle, the particle count is a multiple of 4 * 4 * 4
+constexpr unsigned groupSize = 64;
+
+//Without a displacement sample taken on the current lists, rebuild after this many steps
+constexpr unsigned maxStepsWithoutSample = 4;
+
+bool CompileProgram(GL::Program& program, const char* source, const SimulationState& state)
+{
+	GL::Shader shader(GL_COMPUTE_SHADER);
+	state.DefineConstants(shader);
+
+	if(!shader.FromFile(source))
+	{
+		Logger::Error() << "Shader compilation [" << source <<"] failed with message: " << shader.GetInfoLog() << '\n';
+		return false;
+	}
+
+	program.AttachShader(shader);
+	if(!program.Link())
+	{
+		Logger::Error() << "Shader linking failed with message: " << program.GetInfoLog() << '\n';
+		return false;
+	}
+
+	return true;
+}
+
+} //unnamed namespace
+
+NeighbourListProgram::NeighbourListProgram(SimulationState& _state, const SimulationProgram& simulation) :
+	state(_state),
+	counterReadback(sizeof(Counters)),
+	built(false),
+	stepsSinceBuild(0),
+	buildCount(0),
+	reportedTruncated(0)
+{
+	CompileShaders();
+
+	state.AttachGrid(build, gridBufferName);
+	state.AttachCellKeys(build, cellKeyBufferName);
+	state.AttachReferencePositions(build, referencePositionBufferName);
+	state.AttachNeighbourCounts(build, neighbourCountBufferName);
+	state.AttachNeighbourLists(build, neighbourListBufferName);
+	state.AttachNeighbourState(build, neighbourStateBufferName);
+
+	state.AttachReferencePositions(density, referencePositionBufferName);
+	state.AttachNeighbourCounts(density, neighbourCountBufferName);
+	state.AttachNeighbourLists(density, neighbourListBufferName);
+	state.AttachNeighbourState(density, neighbourStateBufferName);
+	state.AttachDensity(density, densityBufferName);
+	state.AttachPressure(density, pressureBufferName);
+
+	state.AttachNeighbourCounts(force, neighbourCountBufferName);
+	state.AttachNeighbourLists(force, neighbourListBufferName);
+	state.AttachDensity(force, densityBufferName);
+	state.AttachPressure(force, pressureBufferName);
+	state.AttachForce(force, forceBufferName);
+
+	simulation.AttachKernelParams(build);
+	simulation.AttachKernelParams(density);
+	simulation.AttachKernelParams(force);
+}
+
+void NeighbourListProgram::CompileShaders()
+{
+	CompileProgram(build, buildSource, state);
+	CompileProgram(density, densitySource, state);
+	CompileProgram(force, forceSource, state);
+}
+
+bool NeighbourListProgram::NeedsRebuild()
+{
+	if(!built)
+		return true;
+
+	counterReadback.Poll();
+	const Counters counters = counterReadback.Latest<Counters>();
+
+	if(counters.truncatedParticles != reportedTruncated)
+	{
+		Logger::Warning() << "Particles with truncated neighbour lists: " << counters.truncatedParticles << '\n';
+		reportedTruncated = counters.truncatedParticles;
+	}
+
+	//Lag 0 is the capture of the last step; older samples may predate the current lists
+	const unsigned long long lag = counterReadback.Lag();
+	if(lag >= stepsSinceBuild)
+		return stepsSinceBuild > maxStepsWithoutSample;
+
+	//Integrations between the build and the sampled step, none means no motion to extrapolate from
+	const unsigned long long sampleStep = stepsSinceBuild - 1 - lag;
+	if(sampleStep == 0)
+		return stepsSinceBuild > maxStepsWithoutSample;
+
+	float displacement;
+	std::memcpy(&displacement, &counters.maxDisplacement, sizeof(displacement));
+
+	const float predicted = displacement * stepsSinceBuild / sampleStep;
+	return predicted > state.NeighbourSkin() / 2;
+}
+
+void NeighbourListProgram::Build()
+{
+	state.ResetNeighbourState();
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	build.Use();
+	state.AttachPosition(build, positionBufferName);
+	glUniform1f(SkinLocation, state.NeighbourSkin());
+
+	glDispatchCompute(state.ParticleCount() / groupSize, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	built = true;
+	stepsSinceBuild = 0;
+	++buildCount;
+}
+
+void NeighbourListProgram::Run()
+{
+	state.ResetOverflowCount();
+	state.ResetNeighbourDisplacement();
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	density.Use();
+	state.AttachPosition(density, positionBufferName);
+
+	glDispatchCompute(state.ParticleCount() / groupSize, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	counterReadback.Capture(state.NeighbourStateBuffer(), 0);
+
+	force.Use();
+	state.AttachPosition(force, positionBufferName);
+	state.AttachVelocity(force, velocityBufferName);
+
+	glDispatchCompute(state.ParticleCount() / groupSize, 1, 1);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	++stepsSinceBuild;
+}
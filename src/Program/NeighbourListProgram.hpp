@@ -0,0 +1,65 @@
+#ifndef NEIGHBOUR_LIST_PROGRAM_HPP
+#define NEIGHBOUR_LIST_PROGRAM_HPP
+
+#include "../Helper/Program.hpp"
+#include "../Helper/ReadbackRing.hpp"
+
+class SimulationState;
+class SimulationProgram;
+
+/**
+ * @brief 可选的 Verlet 邻居表阶段：排序后为每个粒子记录平滑半径加 skin 内的邻居，
+ * 之后的密度与受力只遍历这些表，直到某个粒子的位移超过 skin 的一半。
+ *
+ * 最大位移由密度阶段在 GPU 上归约，经 ReadbackRing 异步读回，因此判断基于几步之前的样本，
+ * 按重建以来的步数线性外推到当前步。
+ */
+class NeighbourListProgram
+{
+private:
+	SimulationState& state;
+
+	GL::Program build;
+	GL::Program density;
+	GL::Program force;
+
+	// SimulationState::NeighbourStateBuffer 的两个字
+	struct Counters
+	{
+		GLuint maxDisplacement;
+		GLuint truncatedParticles;
+	};
+
+	GL::ReadbackRing counterReadback;
+
+	bool built;
+	unsigned stepsSinceBuild;
+	unsigned buildCount;
+	unsigned reportedTruncated;
+
+	void CompileShaders();
+public:
+	NeighbourListProgram(SimulationState& _state, const SimulationProgram& simulation);
+
+	/**
+	 * @brief 根据最近读回的位移判断下一步之前是否需要重新排序并重建邻居表。
+	 */
+	bool NeedsRebuild();
+
+	/**
+	 * @brief 从刚排好序的网格重建邻居表，须在 GridProgram::Run 之后调用。
+	 */
+	void Build();
+
+	/**
+	 * @brief 用邻居表计算密度、压强与受力，代替 SimulationProgram::Run。
+	 */
+	void Run();
+
+	inline unsigned BuildCount() const
+	{
+		return buildCount;
+	}
+};
+
+#endif //NEIGHBOUR_LIST_PROGRAM_HPP
@@ -0,0 +1,241 @@
+#include "PressureSolverProgram.hpp"
+
+#include "SimulationProgram.hpp"
+#include "../SPHSimulation/SimulationState.hpp"
+#include "../SPHSimulation/SimulationConfig.hpp"
+#include "../SPHSimulation/PredictiveCorrection.hpp"
+#include "../Log/Logger.h"
+
+namespace
+{
+
+constexpr const char* positionBufferName = "positionBuffer";
+constexpr const char* velocityBufferName = "velocityBuffer";
+constexpr const char* densityBufferName = "densityBuffer";
+constexpr const char* pressureBufferName = "pressureBuffer";
+constexpr const char* forceBufferName = "forceBuffer";
+constexpr const char* gridBufferName = "gridBuffer";
+constexpr const char* cellKeyBufferName = "cellKeyBuffer";
+constexpr const char* activeCellBufferName = "activeCellBuffer";
+constexpr const char* overflowBufferName = "overflowBuffer";
+constexpr const char* viscosityForceBufferName = "viscosityForceBuffer";
+constexpr const char* predictedPositionBufferName = "predictedPositionBuffer";
+constexpr const char* pressureSolverStateBufferName = "pressureSolverStateBuffer";
+constexpr const char* pressureSolverDispatchBufferName = "pressureSolverDispatchBuffer";
+
+constexpr const char* densitySource = "../shaders/Simulation/new.comp";
+constexpr const char* forceSource = "../shaders/Simulation/forcenew.comp";
+constexpr const char* predictSource = "../shaders/Simulation/pressurePredict.comp";
+constexpr const char* convergeSource = "../shaders/Simulation/pressureConverge.comp";
+constexpr const char* wallBoundarySource = "../shaders/Simulation/wallBoundary.glsl";
+
+constexpr const unsigned DtLocation = 0;
+constexpr const unsigned GravityLocation = 1;
+constexpr const unsigned InverseDtSquaredLocation = 0;
+constexpr const unsigned ToleranceLocation = 0;
+constexpr const unsigned MinIterationsLocation = 1;
+
+//pressurePredict.comp runs one thread per particle, the particle count is a multiple of 4 * 4 * 4
+constexpr unsigned particleGroupSize = 64;
+
+//Offsets of the three commands in SimulationState::PressureSolverDispatchBuffer
+constexpr GLintptr cellDispatchOffset = 0;
+constexpr GLintptr particleDispatchOffset = 3 * sizeof(GLuint);
+constexpr GLintptr convergeDispatchOffset = 6 * sizeof(GLuint);
+
+bool CompileProgram(GL::Program& program, const char* source, const SimulationState& state, bool useSubgroups, const char* variant)
+{
+	GL::Shader shader(GL_COMPUTE_SHADER);
+	state.DefineConstants(shader);
+	shader.Define("WALL_BOUNDARY");
+	shader.Include(wallBoundarySource);
+	if(useSubgroups)
+	{
+		shader.Define("USE_SUBGROUPS");
+	}
+	if(variant)
+	{
+		shader.Define(variant);
+	}
+
+	if(!shader.FromFile(source))
+	{
+		Logger::Error() << "Shader compilation [" << source <<"] failed with message: " << shader.GetInfoLog() << '\n';
+		return false;
+	}
+
+	program.AttachShader(shader);
+	if(!program.Link())
+	{
+		Logger::Error() << "Shader linking failed with message: " << program.GetInfoLog() << '\n';
+		return false;
+	}
+
+	return true;
+}
+
+} //unnamed namespace
+
+PressureSolverProgram::PressureSolverProgram(SimulationState& _state, const SimulationProgram& simulation, const SimulationConfig& config) :
+	state(_state),
+	counterReadback(sizeof(Counters)),
+	maxIterations(config.pressureIterations),
+	densityTolerance(config.densityTolerance),
+	reportedIterations(0)
+{
+	CompileShaders(simulation.UsesSubgroupReduction());
+
+	state.AttachPressure(density, pressureBufferName);
+	state.AttachDensity(density, densityBufferName);
+	state.AttachGrid(density, gridBufferName);
+	state.AttachCellKeys(density, cellKeyBufferName);
+	state.AttachActiveCells(density, activeCellBufferName);
+	state.AttachOverflow(density, overflowBufferName);
+
+	//Run with the pressure cleared, so only viscosity is left
+	state.AttachPressure(viscosity, pressureBufferName);
+	state.AttachDensity(viscosity, densityBufferName);
+	state.AttachGrid(viscosity, gridBufferName);
+	state.AttachCellKeys(viscosity, cellKeyBufferName);
+	state.AttachActiveCells(viscosity, activeCellBufferName);
+	state.AttachViscosityForce(viscosity, forceBufferName);
+
+	state.AttachForce(predict, forceBufferName);
+	state.AttachDensity(predict, densityBufferName);
+	state.AttachPredictedPosition(predict, predictedPositionBufferName);
+
+	state.AttachPredictedPosition(correct, positionBufferName);
+	state.AttachPressure(correct, pressureBufferName);
+	state.AttachGrid(correct, gridBufferName);
+	state.AttachCellKeys(correct, cellKeyBufferName);
+	state.AttachActiveCells(correct, activeCellBufferName);
+	state.AttachPressureSolverState(correct, pressureSolverStateBufferName);
+
+	state.AttachPressure(pressureForce, pressureBufferName);
+	state.AttachDensity(pressureForce, densityBufferName);
+	state.AttachGrid(pressureForce, gridBufferName);
+	state.AttachCellKeys(pressureForce, cellKeyBufferName);
+	state.AttachActiveCells(pressureForce, activeCellBufferName);
+	state.AttachViscosityForce(pressureForce, viscosityForceBufferName);
+	state.AttachForce(pressureForce, forceBufferName);
+
+	state.AttachPressureSolverState(converge, pressureSolverStateBufferName);
+	state.AttachPressureSolverDispatch(converge, pressureSolverDispatchBufferName);
+
+	simulation.AttachKernelParams(density);
+	simulation.AttachKernelParams(viscosity);
+	simulation.AttachKernelParams(correct);
+	simulation.AttachKernelParams(pressureForce);
+}
+
+void PressureSolverProgram::CompileShaders(bool useSubgroups)
+{
+	//Same reduction variant as SimulationProgram, which already checked that it builds
+	CompileProgram(density, densitySource, state, useSubgroups, nullptr);
+	CompileProgram(viscosity, forceSource, state, useSubgroups, nullptr);
+	CompileProgram(predict, predictSource, state, false, nullptr);
+	CompileProgram(correct, densitySource, state, useSubgroups, "PREDICT_DENSITY");
+	CompileProgram(pressureForce, forceSource, state, useSubgroups, "PRESSURE_FORCE");
+	CompileProgram(converge, convergeSource, state, false, nullptr);
+}
+
+void PressureSolverProgram::ResetDispatch()
+{
+	GL::Buffer& dispatch = state.PressureSolverDispatchBuffer();
+
+	//Cell count from GridProgram's compaction pass, the other two are fixed
+	glCopyNamedBufferSubData(state.CellDispatchBuffer().GetId(), dispatch.GetId(), 0, cellDispatchOffset, 3 * sizeof(GLuint));
+
+	const GLuint fixedArgs[6] = {state.ParticleCount() / particleGroupSize, 1, 1, 1, 1, 1};
+	dispatch.BufferSubData(particleDispatchOffset, sizeof(fixedArgs), fixedArgs);
+}
+
+void PressureSolverProgram::Run(float dt, const glm::vec3& gravityDir)
+{
+	state.ResetOverflowCount();
+	state.ResetPressureSolverState();
+	ResetDispatch();
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	state.CellDispatchBuffer().Bind(GL_DISPATCH_INDIRECT_BUFFER);
+
+	density.Use();
+	state.AttachPosition(density, positionBufferName);
+
+	glDispatchComputeIndirect(0);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	state.ResetPressure();
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	viscosity.Use();
+	state.AttachPosition(viscosity, positionBufferName);
+	state.AttachVelocity(viscosity, velocityBufferName);
+
+	glDispatchComputeIndirect(0);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	//Start from the previous step's pressure, rebuilding the hydrostatic pressure from zero every step never converges
+	state.RestorePreviousPressure();
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	pressureForce.Use();
+	state.AttachPosition(pressureForce, positionBufferName);
+
+	glDispatchComputeIndirect(0);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	//Iterations past convergence find their indirect arguments zeroed by pressureConverge.comp
+	state.PressureSolverDispatchBuffer().Bind(GL_DISPATCH_INDIRECT_BUFFER);
+
+	for(unsigned iteration = 0; iteration < maxIterations; ++iteration)
+	{
+		predict.Use();
+		state.AttachPosition(predict, positionBufferName);
+		state.AttachVelocity(predict, velocityBufferName);
+		glUniform1f(DtLocation, dt);
+		glUniform3fv(GravityLocation, 1, reinterpret_cast<const GLfloat*>(&gravityDir[0]));
+
+		glDispatchComputeIndirect(particleDispatchOffset);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+		correct.Use();
+		glUniform1f(InverseDtSquaredLocation, 1.0f / (dt * dt));
+
+		glDispatchComputeIndirect(cellDispatchOffset);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+		pressureForce.Use();
+		state.AttachPosition(pressureForce, positionBufferName);
+
+		glDispatchComputeIndirect(cellDispatchOffset);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+		converge.Use();
+		glUniform1f(ToleranceLocation, densityTolerance * SPH::RestDensity);
+		glUniform1ui(MinIterationsLocation, SPH::MinPressureIterations);
+
+		glDispatchComputeIndirect(convergeDispatchOffset);
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+	}
+
+	counterReadback.Capture(state.PressureSolverStateBuffer(), 0);
+}
+
+void PressureSolverProgram::ReportIterations()
+{
+	if(!counterReadback.Poll())
+		return;
+
+	const unsigned iterations = LastIterations();
+	if(iterations != reportedIterations)
+	{
+		Logger::Debug() << "PCISPH iterations: " << iterations << '\n';
+		reportedIterations = iterations;
+	}
+}
+
+unsigned PressureSolverProgram::LastIterations() const
+{
+	return counterReadback.Latest<Counters>().iterations;
+}
@@ -0,0 +1,71 @@
+#ifndef PRESSURE_SOLVER_PROGRAM_HPP
+#define PRESSURE_SOLVER_PROGRAM_HPP
+
+#include "../Helper/Program.hpp"
+#include "../Helper/ReadbackRing.hpp"
+
+#include <glm/vec3.hpp>
+
+class SimulationState;
+class SimulationProgram;
+struct SimulationConfig;
+
+/**
+ * @brief PCISPH 压强求解：代替 SimulationProgram::Run 的状态方程，迭代修正压强直到预测密度接近静止密度。
+ *
+ * 每步先以零压强运行受力阶段得到粘性力，之后每次迭代依次预测位置、在预测位置上求密度并修正压强、
+ * 求压强力。密度与受力沿用 new.comp / forcenew.comp 的按单元分块内核，只是以宏切换输入输出。
+ * 收敛由 pressureConverge.comp 在 GPU 上判断，它清零剩余迭代的间接分派参数，CPU 不需要等待结果；
+ * 实际迭代次数与误差经 ReadbackRing 异步读回，仅用于日志。
+ */
+class PressureSolverProgram
+{
+private:
+	SimulationState& state;
+
+	GL::Program density;
+	GL::Program viscosity;
+	GL::Program predict;
+	GL::Program correct;
+	GL::Program pressureForce;
+	GL::Program converge;
+
+	// SimulationState::PressureSolverStateBuffer 的三个字
+	struct Counters
+	{
+		GLuint maxDensityError;
+		GLuint iterations;
+		GLuint lastDensityError;
+	};
+
+	GL::ReadbackRing counterReadback;
+
+	const unsigned maxIterations;
+	const float densityTolerance;
+
+	unsigned reportedIterations;
+
+	void CompileShaders(bool useSubgroups);
+	void ResetDispatch();
+public:
+	PressureSolverProgram(SimulationState& _state, const SimulationProgram& simulation, const SimulationConfig& config);
+
+	/**
+	 * @brief 计算密度、边缘粒子与包含压强力的总受力，须在 GridProgram::Run 之后调用。
+	 * @param dt 本步的积分步长。
+	 * @param gravityDir 重力方向，与积分阶段一致。
+	 */
+	void Run(float dt, const glm::vec3& gravityDir);
+
+	/**
+	 * @brief 取回已完成的回读结果，迭代次数变化时写一条调试日志。每步调用一次，不会等待 GPU。
+	 */
+	void ReportIterations();
+
+	/**
+	 * @brief 最近一次已回读的某一步实际执行的迭代次数，不取回新的结果。
+	 */
+	unsigned LastIterations() const;
+};
+
+#endif //PRESSURE_SOLVER_PROGRAM_HPP
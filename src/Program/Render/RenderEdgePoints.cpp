@@ -42,8 +42,6 @@ void RenderEdgePoints::Render(const glm::vec3& eye, const glm::vec3& planeOrigin
 {
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	unsigned edgeCount = state.GetEdgeCount();
-
 	renderProgram.Use();
 	va.Bind();
 
@@ -54,5 +52,6 @@ void RenderEdgePoints::Render(const glm::vec3& eye, const glm::vec3& planeOrigin
 	glUniform1i(BoundaryTypeLocation, boundaryType);
 	glUniform1f(BoundaryRadiusLocation, boundaryRadius);
 
-	glDrawArrays(GL_POINTS, 0, edgeCount);
+	state.EdgeDispatchBuffer().Bind(GL_DRAW_INDIRECT_BUFFER);
+	glDrawArraysIndirect(GL_POINTS, reinterpret_cast<const void*>(SimulationState::EdgeDrawOffset));
 }
@@ -37,7 +37,8 @@ RenderPoints::RenderPoints(SimulationState& _state) :
 
 void RenderPoints::CompileShaders()
 {
-	if(!renderProgram.VsFsProgram(VertexSource, FragmentSource))
+	auto defineConstants = [this](GL::Shader& shader) { state.DefineConstants(shader); };
+	if(!renderProgram.VsFsProgram(VertexSource, FragmentSource, defineConstants))
 	{
 		Logger::Error() << "Render Program linking failed: " << renderProgram.GetInfoLog() <<  '\n';
 	}
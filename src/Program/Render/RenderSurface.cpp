@@ -1,6 +1,7 @@
 #include "RenderSurface.hpp"
 
 #include "../../SPHSimulation/SimulationState.hpp"
+#include "../../SPHSimulation/DistanceField.hpp"
 #include "../../Log/Logger.h"
 
 #include <glm/vec3.hpp>
@@ -10,17 +11,61 @@
 #include <glm/gtx/transform2.hpp>
 
 static constexpr const char* EdgeBufferName = "edgeBuffer";
+static constexpr const char* SeedSource = "../shaders/Render/jumpFloodSeed.comp";
+static constexpr const char* JumpFloodSource = "../shaders/Render/jumpFlood.comp";
 static constexpr const char* DistanceSource = "../shaders/Render/distanceField.comp";
+static constexpr const char* MinReduceSource = "../shaders/Render/minReduce.comp";
 static constexpr const char* VertexSource = "../shaders/Render/quad.vert";
 static constexpr const char* FragmentSource = "../shaders/Render/raycast.frag";
+static constexpr const char* UpsampleSource = "../shaders/Render/upsample.frag";
+static constexpr const char* ReprojectSource = "../shaders/Render/reproject.frag";
 
 static constexpr const unsigned DistanceTextureUnit = 0;
+// Image units of the jump flood seed textures, read from the first and written to the second
+static constexpr const unsigned SourceSeedUnit = 1;
+static constexpr const unsigned TargetSeedUnit = 2;
+
+// Image units of the min pyramid level read and the one written, shared with the seeds
+static constexpr const unsigned SourceLevelUnit = 1;
+static constexpr const unsigned TargetLevelUnit = 2;
+
+// Voxels per workgroup side in jumpFlood.comp, distanceField.comp and minReduce.comp
+static constexpr const unsigned VoxelGroupSize = 4;
+
+static constexpr const unsigned StepLocation = 0;
 
 static constexpr const unsigned TextureLocation = 0;
 static constexpr const unsigned EyeLocation = 1;
 static constexpr const unsigned WorldLocation = 2;
 static constexpr const unsigned BoundaryLocation = 3;
 static constexpr const unsigned BoundaryRadiusLocation = 4;
+static constexpr const unsigned MarchModeLocation = 5;
+static constexpr const unsigned ShowStepsLocation = 6;
+static constexpr const unsigned ParityLocation = 7;
+
+// upsample.frag, the distance field keeps texture unit 0
+static constexpr const unsigned LowColorUnit = 1;
+static constexpr const unsigned LowSurfaceUnit = 2;
+static constexpr const unsigned LowColorLocation = 0;
+static constexpr const unsigned LowSurfaceLocation = 1;
+static constexpr const unsigned LowScaleLocation = 3;
+
+// reproject.frag reads the pixels marched this frame and the previous frame
+static constexpr const unsigned CurrentColorUnit = 1;
+static constexpr const unsigned CurrentSurfaceUnit = 2;
+static constexpr const unsigned HistoryColorUnit = 3;
+static constexpr const unsigned HistorySurfaceUnit = 4;
+static constexpr const unsigned CurrentColorLocation = 0;
+static constexpr const unsigned CurrentSurfaceLocation = 1;
+static constexpr const unsigned HistoryColorLocation = 3;
+static constexpr const unsigned HistorySurfaceLocation = 4;
+static constexpr const unsigned ReprojectEyeLocation = 5;
+static constexpr const unsigned PrevEyeLocation = 6;
+static constexpr const unsigned PrevPlaneOriginLocation = 7;
+static constexpr const unsigned PrevPlaneAxisXLocation = 8;
+static constexpr const unsigned PrevPlaneAxisYLocation = 9;
+static constexpr const unsigned ReprojectParityLocation = 10;
+static constexpr const unsigned HistoryExactLocation = 11;
 
 RenderSurface::RenderSurface(SimulationState& _state) :
 	state(_state),
@@ -28,8 +73,9 @@ RenderSurface::RenderSurface(SimulationState& _state) :
 {
 	CompileShaders();
 
+	state.AttachEdge(seedProgram, EdgeBufferName);
+	state.AttachEdge(jumpFloodProgram, EdgeBufferName);
 	state.AttachEdge(distanceFieldProgram, EdgeBufferName);
-	state.AttachDensity(distanceFieldProgram, "densityBuffer");
 
 	SetDistanceTextureSize(64);
 }
@@ -55,31 +101,102 @@ static bool CompileProgram(GL::Program& program, const char* source)
 
 void RenderSurface::CompileShaders()
 {
+	CompileProgram(seedProgram, SeedSource);
+	CompileProgram(jumpFloodProgram, JumpFloodSource);
 	CompileProgram(distanceFieldProgram, DistanceSource);
+	CompileProgram(minReduceProgram, MinReduceSource);
 
 	if(!raycastProgram.VsFsProgram(VertexSource, FragmentSource))
 	{
 		Logger::Error() << "Render Program linking failed: " << raycastProgram.GetInfoLog() <<  '\n';
 	}
+
+	if(!upsampleProgram.VsFsProgram(VertexSource, UpsampleSource))
+	{
+		Logger::Error() << "Upsample Program linking failed: " << upsampleProgram.GetInfoLog() <<  '\n';
+	}
+
+	if(!reprojectProgram.VsFsProgram(VertexSource, ReprojectSource))
+	{
+		Logger::Error() << "Reproject Program linking failed: " << reprojectProgram.GetInfoLog() <<  '\n';
+	}
 }
 
 void RenderSurface::DistanceField()
 {
-	if(!distanceFieldProgram)
+	if(!seedProgram || !jumpFloodProgram || !distanceFieldProgram)
 		return;
-	unsigned edgeCount = state.GetEdgeCount();
 
-	float max = 1.0;
-	glClearTexImage(distanceFieldTexture->GetId(), 0, GL_RED, GL_FLOAT, &max);
+	++fieldVersion;
+
+	const GLuint noSeed = SPH::NoSeed;
+	glClearTexImage(seedTextures[0]->GetId(), 0, GL_RED_INTEGER, GL_UNSIGNED_INT, &noSeed);
 	glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 
+	//Each edge particle marks its voxel, sized from the edge count on the GPU
+	seedProgram.Use();
+	glBindImageTexture(SourceSeedUnit, seedTextures[0]->GetId(), 0, GL_TRUE, 0, GL_READ_WRITE, GL_R32UI);
+	state.EdgeDispatchBuffer().Bind(GL_DISPATCH_INDIRECT_BUFFER);
+	glDispatchComputeIndirect(SimulationState::EdgeDispatchOffset);
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+	//Halving steps, then one more step of 1 (JFA+1) to fix most of the remaining misses
+	jumpFloodProgram.Use();
+	unsigned source = 0;
+	for(unsigned step = SPH::JumpFloodFirstStep(distanceTextureSize); step > 0; step /= 2)
+	{
+		JumpFloodPass(source, step);
+		source = 1 - source;
+	}
+	JumpFloodPass(source, 1);
+	source = 1 - source;
+
+	//Every voxel is written once, so the field doesn't have to be cleared first
 	distanceFieldProgram.Use();
+	glBindImageTexture(SourceSeedUnit, seedTextures[source]->GetId(), 0, GL_TRUE, 0, GL_READ_ONLY, GL_R32UI);
 	// Provide boundary selection to compute shader
 	glUniform1i(BoundaryLocation, static_cast<GLint>(GetBoundaryMode()));
 	glUniform1f(BoundaryRadiusLocation, GetBoundaryRadius());
-	glDispatchCompute(edgeCount / 64 + 1, 1, 1);
 
-	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+	const GLuint groups = (distanceTextureSize + VoxelGroupSize - 1) / VoxelGroupSize;
+	glDispatchCompute(groups, groups, groups);
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+	MinReduce();
+
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void RenderSurface::MinReduce()
+{
+	if(!minReduceProgram)
+		return;
+
+	//Each level takes the minimum of 2x2x2 voxels of the one below, for skipping empty blocks in raycast.frag
+	minReduceProgram.Use();
+	const unsigned levels = SPH::DistanceFieldLevels(distanceTextureSize);
+	for(unsigned level = 1; level < levels; ++level)
+	{
+		const GLuint groups = ((distanceTextureSize >> level) + VoxelGroupSize - 1) / VoxelGroupSize;
+
+		glBindImageTexture(SourceLevelUnit, distanceFieldTexture->GetId(), level - 1, GL_TRUE, 0, GL_READ_ONLY, GL_R32F);
+		glBindImageTexture(TargetLevelUnit, distanceFieldTexture->GetId(), level, GL_TRUE, 0, GL_WRITE_ONLY, GL_R32F);
+
+		glDispatchCompute(groups, groups, groups);
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+	}
+}
+
+void RenderSurface::JumpFloodPass(unsigned source, unsigned step)
+{
+	const GLuint groups = (distanceTextureSize + VoxelGroupSize - 1) / VoxelGroupSize;
+
+	glBindImageTexture(SourceSeedUnit, seedTextures[source]->GetId(), 0, GL_TRUE, 0, GL_READ_ONLY, GL_R32UI);
+	glBindImageTexture(TargetSeedUnit, seedTextures[1 - source]->GetId(), 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_R32UI);
+	glUniform1i(StepLocation, static_cast<GLint>(step));
+
+	glDispatchCompute(groups, groups, groups);
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
 }
 
 void RenderSurface::Raycast()
@@ -88,6 +205,61 @@ void RenderSurface::Raycast()
 		return;
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	//Without the offscreen passes every pixel is marched straight into the window
+	if(!upsampleProgram || !reprojectProgram || viewport[2] <= 0 || viewport[3] <= 0)
+	{
+		MarchPass(-1);
+		return;
+	}
+
+	const unsigned scale = RaycastScale(viewport[2], viewport[3]);
+	ResizeFrameTargets((viewport[2] + scale - 1) / scale, (viewport[3] + scale - 1) / scale);
+
+	//An idle view presents the last result again, a checkerboarded one needs the other parity first
+	const RaycastKey key = CurrentKey();
+	const bool unchanged = historyValid && key == historyKey;
+	if(!unchanged || freshParities < 2)
+	{
+		const unsigned target = 1 - currentFrame;
+
+		//Unblended, the colour is blended over the background when presenting
+		frameBuffers[target].Bind();
+		glViewport(0, 0, frameWidth, frameHeight);
+		glDisable(GL_BLEND);
+
+		if(checkerboard && historyValid)
+		{
+			MarchPass(static_cast<int>(parity));
+			//The reconstruction reads the pixels just marched into the target and writes the others
+			glTextureBarrier();
+			ReconstructPass(target, unchanged);
+
+			freshParities = unchanged ? freshParities + 1 : 1;
+			parity = 1 - parity;
+		}
+		else
+		{
+			MarchPass(-1);
+			freshParities = 2;
+		}
+
+		glEnable(GL_BLEND);
+		GL::Framebuffer::BindDefault();
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+		currentFrame = target;
+		historyKey = key;
+		historyValid = true;
+	}
+
+	Present(viewport[2], viewport[3]);
+}
+
+void RenderSurface::MarchPass(int marchedParity)
+{
 	raycastProgram.Use();
 	va.Bind();
 
@@ -102,9 +274,122 @@ void RenderSurface::Raycast()
 	glUniform1i(BoundaryLocation, static_cast<GLint>(GetBoundaryMode()));
 	glUniform1f(BoundaryRadiusLocation, GetBoundaryRadius());
 
+	glUniform1i(MarchModeLocation, static_cast<GLint>(marchMode));
+	glUniform1i(ShowStepsLocation, showSteps ? GL_TRUE : GL_FALSE);
+	glUniform1i(ParityLocation, marchedParity);
+
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+void RenderSurface::ReconstructPass(unsigned target, bool exact)
+{
+	const unsigned history = currentFrame;
+
+	//The screen plane of the previous frame, as the scene passes it to RenderPoints
+	const glm::mat4& previousView = historyKey.view;
+	const glm::vec3 planeOrigin = glm::vec3(previousView * glm::vec4(-1, -1, 0, 1));
+	const glm::vec3 planeAxisX = glm::vec3(previousView * glm::vec4( 1, -1, 0, 1)) - planeOrigin;
+	const glm::vec3 planeAxisY = glm::vec3(previousView * glm::vec4(-1,  1, 0, 1)) - planeOrigin;
+
+	reprojectProgram.Use();
+	va.Bind();
+
+	frameColor[target]->Bind(CurrentColorUnit);
+	frameSurface[target]->Bind(CurrentSurfaceUnit);
+	frameColor[history]->Bind(HistoryColorUnit);
+	frameSurface[history]->Bind(HistorySurfaceUnit);
+
+	glUniform1i(CurrentColorLocation, CurrentColorUnit);
+	glUniform1i(CurrentSurfaceLocation, CurrentSurfaceUnit);
+	glUniform1i(HistoryColorLocation, HistoryColorUnit);
+	glUniform1i(HistorySurfaceLocation, HistorySurfaceUnit);
+
+	glUniformMatrix4fv(WorldLocation, 1, GL_FALSE, reinterpret_cast<const GLfloat*>(&camera.GetView()[0][0]));
+	glUniform3fv(ReprojectEyeLocation, 1, reinterpret_cast<const GLfloat*>(&camera.GetEye()[0]));
+	glUniform3fv(PrevEyeLocation, 1, reinterpret_cast<const GLfloat*>(&historyKey.eye[0]));
+	glUniform3fv(PrevPlaneOriginLocation, 1, reinterpret_cast<const GLfloat*>(&planeOrigin[0]));
+	glUniform3fv(PrevPlaneAxisXLocation, 1, reinterpret_cast<const GLfloat*>(&planeAxisX[0]));
+	glUniform3fv(PrevPlaneAxisYLocation, 1, reinterpret_cast<const GLfloat*>(&planeAxisY[0]));
+	glUniform1i(ReprojectParityLocation, static_cast<GLint>(parity));
+	glUniform1i(HistoryExactLocation, exact ? GL_TRUE : GL_FALSE);
+
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 }
 
+void RenderSurface::Present(int width, int height)
+{
+	upsampleProgram.Use();
+	va.Bind();
+
+	frameColor[currentFrame]->Bind(LowColorUnit);
+	frameSurface[currentFrame]->Bind(LowSurfaceUnit);
+	glUniform1i(LowColorLocation, LowColorUnit);
+	glUniform1i(LowSurfaceLocation, LowSurfaceUnit);
+	glUniform2f(LowScaleLocation,
+		static_cast<GLfloat>(frameWidth) / width, static_cast<GLfloat>(frameHeight) / height);
+
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+RenderSurface::RaycastKey RenderSurface::CurrentKey() const
+{
+	RaycastKey key;
+	key.view = camera.GetView();
+	key.eye = camera.GetEye();
+	key.fieldVersion = fieldVersion;
+	key.boundaryMode = boundaryMode;
+	key.boundaryRadius = boundaryRadius;
+	key.marchMode = marchMode;
+	key.showSteps = showSteps;
+	return key;
+}
+
+unsigned RenderSurface::RaycastScale(int width, int height) const
+{
+	if(renderScale > 0)
+		return renderScale;
+
+	unsigned scale = 1;
+	while(scale < 4 &&
+		static_cast<unsigned>((width + scale - 1) / scale) * ((height + scale - 1) / scale) > AutoScalePixels)
+	{
+		scale *= 2;
+	}
+	return scale;
+}
+
+void RenderSurface::ResizeFrameTargets(int width, int height)
+{
+	if(width == frameWidth && height == frameHeight)
+		return;
+
+	frameWidth = width;
+	frameHeight = height;
+	historyValid = false;
+
+	for(unsigned i = 0; i < 2; ++i)
+	{
+		frameColor[i] = std::make_unique<GL::Texture>(GL_TEXTURE_2D);
+		glTextureStorage2D(frameColor[i]->GetId(), 1, GL_RGBA8, width, height);
+
+		frameSurface[i] = std::make_unique<GL::Texture>(GL_TEXTURE_2D);
+		glTextureStorage2D(frameSurface[i]->GetId(), 1, GL_RGBA16F, width, height);
+
+		//Read with texelFetch only
+		frameColor[i]->SetMinFilter(GL_NEAREST);
+		frameSurface[i]->SetMinFilter(GL_NEAREST);
+
+		frameBuffers[i].AttachColor(0, *frameColor[i]);
+		frameBuffers[i].AttachColor(1, *frameSurface[i]);
+		frameBuffers[i].DrawColorAttachments(2);
+
+		if(!frameBuffers[i].IsComplete())
+		{
+			Logger::Error() << "Raycast target " << width << 'x' << height << " is incomplete\n";
+		}
+	}
+}
+
 void RenderSurface::Update(float delta)
 {
 	camera.Update(delta);
@@ -122,10 +407,19 @@ void RenderSurface::Render()
 
 void RenderSurface::SetDistanceTextureSize(unsigned length)
 {
+	distanceTextureSize = length;
+
+	for(std::unique_ptr<GL::Texture>& seeds : seedTextures)
+	{
+		seeds = std::make_unique<GL::Texture>(GL_TEXTURE_3D);
+		glTextureStorage3D(seeds->GetId(), 1, GL_R32UI, length, length, length);
+	}
+
 	distanceFieldTexture = std::make_unique<GL::Texture>(GL_TEXTURE_3D);
 
-	glTextureStorage3D(distanceFieldTexture->GetId(), 1, GL_R32F, length, length, length);
-	glTextureParameteri(distanceFieldTexture->GetId(), GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	//Level 0 is the field, the rest is the min pyramid from MinReduce; raycast.frag samples level 0 explicitly
+	glTextureStorage3D(distanceFieldTexture->GetId(), SPH::DistanceFieldLevels(length), GL_R32F, length, length, length);
+	glTextureParameteri(distanceFieldTexture->GetId(), GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
 	glTextureParameteri(distanceFieldTexture->GetId(), GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
 	glTextureParameteri(distanceFieldTexture->GetId(), GL_TEXTURE_WRAP_S,  GL_MIRRORED_REPEAT);
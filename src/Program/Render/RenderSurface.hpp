@@ -4,6 +4,7 @@
 #include "../../Helper/Texture.h"
 #include "../../Helper/Program.hpp"
 #include "../../Helper/VertexArray.hpp"
+#include "../../Helper/Framebuffer.hpp"
 
 #include "OrbiterCamera.hpp"
 #include "Direction.hpp"
@@ -17,9 +18,26 @@ class RenderSurface
 private:
 	SimulationState& state;
 	std::unique_ptr<GL::Texture> distanceFieldTexture;
+	unsigned distanceTextureSize;
 
+	// 跳跃泛洪的种子纹理（每个体素最近边缘粒子的下标），各次传播间交替读写
+	std::unique_ptr<GL::Texture> seedTextures[2];
+
+	GL::Program seedProgram;
+	GL::Program jumpFloodProgram;
 	GL::Program distanceFieldProgram;
+	GL::Program minReduceProgram;
 	GL::Program raycastProgram;
+	GL::Program upsampleProgram;
+	GL::Program reprojectProgram;
+
+	// 光线投射的目标（窗口的 1/n）：颜色与不透明度、首个命中点的法线与深度；两组交替作为本帧与上一帧
+	std::unique_ptr<GL::Texture> frameColor[2];
+	std::unique_ptr<GL::Texture> frameSurface[2];
+	GL::Framebuffer frameBuffers[2];
+	unsigned currentFrame = 0;
+	int frameWidth = 0;
+	int frameHeight = 0;
 
 	GL::VertexArray va;
 
@@ -32,9 +50,64 @@ private:
 	BoundaryMode boundaryMode = BoundaryMode::Cube;
 	float boundaryRadius = 0.5f;
 
+	/**
+	 * @brief 光线步进方式。
+	 * FixedStep 每 0.005 采样一次；SphereTracing 按采样到的距离跳过空白区域，只在表面附近按固定步长积分。
+	 */
+	enum class MarchMode { FixedStep = 0, SphereTracing = 1 };
+	MarchMode marchMode = MarchMode::SphereTracing;
+
+	// 显示每个像素的步进次数而不是表面
+	bool showSteps = false;
+
+	// 光线投射分辨率的除数（1、2 或 4），为 0 时按窗口大小选取，使投射的像素数不超过 AutoScalePixels
+	unsigned renderScale = 1;
+
+	/**
+	 * @brief 决定光线投射结果的全部输入，与上一帧相同时不再投射。
+	 */
+	struct RaycastKey
+	{
+		glm::mat4 view;
+		glm::vec3 eye;
+		unsigned fieldVersion;
+		BoundaryMode boundaryMode;
+		float boundaryRadius;
+		MarchMode marchMode;
+		bool showSteps;
+
+		bool operator==(const RaycastKey& other) const
+		{
+			return view == other.view && eye == other.eye && fieldVersion == other.fieldVersion &&
+				boundaryMode == other.boundaryMode && boundaryRadius == other.boundaryRadius &&
+				marchMode == other.marchMode && showSteps == other.showSteps;
+		}
+	};
+
+	// 每次重建距离场加一
+	unsigned fieldVersion = 0;
+
+	// currentFrame 中结果对应的输入；historyValid 为 false 时目标尚未写过或尺寸已变
+	RaycastKey historyKey;
+	bool historyValid = false;
+
+	// 启用时每帧只投射一半像素（棋盘格），其余由上一帧重投影
+	bool checkerboard = false;
+	// 下一次投射的棋盘格奇偶性，以及以 historyKey 投射过的奇偶数（为 2 时结果完整）
+	unsigned parity = 0;
+	unsigned freshParities = 0;
+
  	void CompileShaders();
 	void DistanceField();
+	void JumpFloodPass(unsigned source, unsigned step);
+	void MinReduce();
 	void Raycast();
+	void MarchPass(int marchedParity);
+	void ReconstructPass(unsigned target, bool exact);
+	void Present(int width, int height);
+	RaycastKey CurrentKey() const;
+	unsigned RaycastScale(int width, int height) const;
+	void ResizeFrameTargets(int width, int height);
 public:
 	RenderSurface(SimulationState& _state);
 
@@ -132,6 +205,78 @@ public:
 	 * @brief 获取当前球体边界半径。
 	 */
 	float GetBoundaryRadius() const { return boundaryRadius; }
+
+	/**
+	 * @brief 在固定步长与球面追踪（sphere tracing）之间切换。
+	 */
+	void ToggleMarchMode()
+	{
+		marchMode = (marchMode == MarchMode::FixedStep) ? MarchMode::SphereTracing : MarchMode::FixedStep;
+	}
+
+	/**
+	 * @brief 当前是否使用球面追踪。
+	 */
+	bool IsSphereTracing() const
+	{
+		return marchMode == MarchMode::SphereTracing;
+	}
+
+	/**
+	 * @brief 切换步进次数热力图（蓝色为少，红色为 400 次上限）。
+	 */
+	void ToggleStepView()
+	{
+		showSteps = !showSteps;
+	}
+
+	/**
+	 * @brief 当前是否显示步进次数热力图。
+	 */
+	bool IsShowingSteps() const { return showSteps; }
+
+	// 自动选取除数时光线投射像素数的上限（1280x720）
+	static constexpr unsigned AutoScalePixels = 1280 * 720;
+
+	/**
+	 * @brief 设置光线投射分辨率的除数。
+	 * @param scale 1、2 或 4，低分辨率结果经深度感知上采样到窗口；0 表示按窗口大小自动选取。
+	 */
+	void SetRenderScale(unsigned scale)
+	{
+		renderScale = scale;
+	}
+
+	/**
+	 * @brief 依次切换 1、1/2、1/4 与自动分辨率。
+	 */
+	void CycleRenderScale()
+	{
+		renderScale = renderScale == 0 ? 1 : (renderScale == 4 ? 0 : renderScale * 2);
+	}
+
+	/**
+	 * @brief 当前光线投射分辨率的除数，0 表示自动。
+	 */
+	unsigned GetRenderScale() const { return renderScale; }
+
+	/**
+	 * @brief 启用或关闭棋盘格投射。
+	 *
+	 * 相机与距离场不变时无论是否启用都直接复用上一帧；启用后变化的帧只投射一半像素，其余由上一帧重投影，
+	 * 静止下来后再投射另一半得到完整结果。
+	 */
+	void SetCheckerboard(bool enabled)
+	{
+		checkerboard = enabled;
+	}
+
+	void ToggleCheckerboard()
+	{
+		checkerboard = !checkerboard;
+	}
+
+	bool IsCheckerboard() const { return checkerboard; }
 };
 
 #endif
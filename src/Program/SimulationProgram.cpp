@@ -13,14 +13,52 @@ constexpr const char* pressureBufferName = "pressureBuffer";
 constexpr const char* forceBufferName = "forceBuffer";
 constexpr const char* velocityBufferName = "velocityBuffer";
 constexpr const char* gridBufferName = "gridBuffer";
-constexpr const char* edgeBufferName = "edgeBuffer";
+constexpr const char* cellKeyBufferName = "cellKeyBuffer";
+constexpr const char* activeCellBufferName = "activeCellBuffer";
+constexpr const char* overflowBufferName = "overflowBuffer";
+constexpr const char* packedParticleBufferName = "packedParticleBuffer";
+constexpr const char* kernelParamsBlockName = "KernelParams";
 
 constexpr const char* pressureSource = "../shaders/Simulation/new.comp";
 constexpr const char* forceSource = "../shaders/Simulation/forcenew.comp";
 
-bool CompileProgram(GL::Program& program, const char* source)
+//Both kernels run 128 threads per workgroup
+constexpr GLint workGroupSize = 128;
+
+bool SubgroupReductionSupported()
+{
+	if(!glewIsSupported("GL_KHR_shader_subgroup"))
+		return false;
+
+	GLint stages = 0;
+	GLint features = 0;
+	GLint subgroupSize = 0;
+	glGetIntegerv(GL_SUBGROUP_SUPPORTED_STAGES_KHR, &stages);
+	glGetIntegerv(GL_SUBGROUP_SUPPORTED_FEATURES_KHR, &features);
+	glGetIntegerv(GL_SUBGROUP_SIZE_KHR, &subgroupSize);
+
+	const GLint required = GL_SUBGROUP_FEATURE_BASIC_BIT_KHR | GL_SUBGROUP_FEATURE_CLUSTERED_BIT_KHR;
+
+	//The lane mapping in the kernels needs subgroups to tile the workgroup exactly
+	return
+		(stages & GL_COMPUTE_SHADER_BIT) != 0 &&
+		(features & required) == required &&
+		subgroupSize > 0 && workGroupSize % subgroupSize == 0;
+}
+
+bool CompileProgram(GL::Program& program, const char* source, const SimulationState& state, bool useSubgroups, bool packNeighbourhood)
 {
 	GL::Shader shader(GL_COMPUTE_SHADER);
+	state.DefineConstants(shader);
+	if(useSubgroups)
+	{
+		shader.Define("USE_SUBGROUPS");
+	}
+	if(packNeighbourhood)
+	{
+		shader.Define("PACK_NEIGHBOURHOOD");
+	}
+
 	if(!shader.FromFile(source))
 	{
 		Logger::Error() << "Shader compilation [" << source <<"] failed with message: " << shader.GetInfoLog() << '\n';
@@ -28,7 +66,12 @@ bool CompileProgram(GL::Program& program, const char* source)
 	}
 
 	program.AttachShader(shader);
-	if(!program.Link())
+	const bool linked = program.Link();
+
+	//Detached either way so the program can be rebuilt with the other variant
+	glDetachShader(program.Get(), shader.GetId());
+
+	if(!linked)
 	{
 		Logger::Error() << "Shader linking failed with message: " << program.GetInfoLog() << '\n';
 		return false;
@@ -37,53 +80,159 @@ bool CompileProgram(GL::Program& program, const char* source)
 	return true;
 }
 
+const char* SolverPathName(SolverPath path)
+{
+	return path == SolverPath::Packed ? "packed" : "separate";
+}
+
 } //unnamed namespace
 
 SimulationProgram::SimulationProgram(SimulationState& _state) :
-	state(_state)
+	state(_state),
+	path(SolverPath::Separate),
+	subgroupReduction(false)
 {
 	CompileShaders();
 
 	state.AttachPressure(pressure, pressureBufferName);
 	state.AttachDensity(pressure, densityBufferName);
 	state.AttachGrid(pressure, gridBufferName);
-	state.AttachEdge(pressure, edgeBufferName);
+	state.AttachCellKeys(pressure, cellKeyBufferName);
+	state.AttachActiveCells(pressure, activeCellBufferName);
+	state.AttachOverflow(pressure, overflowBufferName);
 
 	state.AttachPressure(force, pressureBufferName);
 	state.AttachDensity(force, densityBufferName);
 	state.AttachGrid(force, gridBufferName);
+	state.AttachCellKeys(force, cellKeyBufferName);
+	state.AttachActiveCells(force, activeCellBufferName);
 	state.AttachForce(force, forceBufferName);
+
+	state.AttachPressure(packedPressure, pressureBufferName);
+	state.AttachDensity(packedPressure, densityBufferName);
+	state.AttachGrid(packedPressure, gridBufferName);
+	state.AttachCellKeys(packedPressure, cellKeyBufferName);
+	state.AttachActiveCells(packedPressure, activeCellBufferName);
+	state.AttachOverflow(packedPressure, overflowBufferName);
+	state.AttachPackedParticles(packedPressure, packedParticleBufferName);
+
+	state.AttachGrid(packedForce, gridBufferName);
+	state.AttachCellKeys(packedForce, cellKeyBufferName);
+	state.AttachActiveCells(packedForce, activeCellBufferName);
+	state.AttachForce(packedForce, forceBufferName);
+	state.AttachPackedParticles(packedForce, packedParticleBufferName);
+
+	kernelParamsBinding.AttachToBlock(pressure, pressure.GetUniformBlockIndex(kernelParamsBlockName));
+	kernelParamsBinding.AttachToBlock(force, force.GetUniformBlockIndex(kernelParamsBlockName));
+	kernelParamsBinding.AttachToBlock(packedPressure, packedPressure.GetUniformBlockIndex(kernelParamsBlockName));
+	kernelParamsBinding.AttachToBlock(packedForce, packedForce.GetUniformBlockIndex(kernelParamsBlockName));
+	kernelParamsBinding.AttachBuffer(kernelParamsBuffer);
+
+	SetKernelParams(SPH::DefaultKernelParams);
+}
+
+void SimulationProgram::SetKernelParams(const SPH::KernelParams& params)
+{
+	kernelParamsBuffer.BufferData(params, GL_STATIC_DRAW);
+	kernelParamsBinding.AttachBuffer(kernelParamsBuffer);
+}
+
+void SimulationProgram::AttachKernelParams(const GL::Program& program) const
+{
+	kernelParamsBinding.AttachToBlock(program, program.GetUniformBlockIndex(kernelParamsBlockName));
 }
 
 void SimulationProgram::CompileShaders()
 {
-	CompileProgram(pressure, pressureSource);
-	CompileProgram(force, forceSource);
+	subgroupReduction = SubgroupReductionSupported();
+
+	if(subgroupReduction &&
+		!(CompileProgram(pressure, pressureSource, state, true, false) && CompileProgram(force, forceSource, state, true, false) &&
+		CompileProgram(packedPressure, pressureSource, state, true, true) && CompileProgram(packedForce, forceSource, state, true, true)))
+	{
+		Logger::Warning() << "Subgroup reduction kernels failed to build, using the shared memory reduction\n";
+		subgroupReduction = false;
+	}
+
+	if(!subgroupReduction)
+	{
+		CompileProgram(pressure, pressureSource, state, false, false);
+		CompileProgram(force, forceSource, state, false, false);
+		CompileProgram(packedPressure, pressureSource, state, false, true);
+		CompileProgram(packedForce, forceSource, state, false, true);
+	}
+
+	Logger::Info() << "SPH reduction: " << (subgroupReduction ? "subgroup" : "shared memory") << '\n';
 }
 
 void SimulationProgram::Run()
 {
-	state.ResetEdgeCount();
+	RunPath(path);
+}
+
+void SimulationProgram::RunPath(SolverPath solverPath)
+{
+	const bool packed = solverPath == SolverPath::Packed;
+	GL::Program& densityPass = packed ? packedPressure : pressure;
+	GL::Program& forcePass = packed ? packedForce : force;
+
+	state.ResetOverflowCount();
 
-	pressure.Use();
-	state.AttachPosition(pressure, positionBufferName);
+	densityPass.Use();
+	state.AttachPosition(densityPass, positionBufferName);
+	if(packed)
+	{
+		//Copied into the packed records next to position and pressure
+		state.AttachVelocity(densityPass, velocityBufferName);
+	}
+
+	//One workgroup per occupied cell, count written by GridProgram's compaction pass
+	state.CellDispatchBuffer().Bind(GL_DISPATCH_INDIRECT_BUFFER);
+	glDispatchComputeIndirect(0);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
 
-	glUniform1f(0, 0.1);
-	glUniform1f(1, 100);
-	glUniform1f(2, 250);
+	forcePass.Use();
+	if(!packed)
+	{
+		state.AttachPosition(forcePass, positionBufferName);
+		state.AttachVelocity(forcePass, velocityBufferName);
+	}
 
-	glDispatchCompute(state.GridRes(), state.GridRes(), state.GridRes());
+	glDispatchComputeIndirect(0);
 	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void SimulationProgram::Benchmark(unsigned iterations)
+{
+	if(iterations == 0)
+		return;
 
-	glFinish();
-	glFlush();
+	GLuint query;
+	glCreateQueries(GL_TIME_ELAPSED, 1, &query);
 
-	force.Use();
-	state.AttachPosition(force, positionBufferName);
-	state.AttachVelocity(force, velocityBufferName);
+	for(SolverPath candidate : {SolverPath::Separate, SolverPath::Packed})
+	{
+		//Warm up so the first dispatch's shader upload isn't timed
+		RunPath(candidate);
+
+		glBeginQuery(GL_TIME_ELAPSED, query);
+		for(unsigned i = 0; i < iterations; ++i)
+		{
+			RunPath(candidate);
+		}
+		glEndQuery(GL_TIME_ELAPSED);
+
+		//Blocks until the GPU is done, acceptable for an explicit benchmark
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+
+		Logger::Info() << "SPH solver path " << SolverPathName(candidate) << ": " <<
+			elapsed / 1.0e6 / iterations << " ms per density and force step" <<
+			(candidate == path ? " (active)" : "") << '\n';
+	}
 
-	glUniform1f(0, 0.1);
+	glDeleteQueries(1, &query);
 
-	glDispatchCompute(state.GridRes(), state.GridRes(), state.GridRes());
-	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	//Leave the outputs of the active path behind
+	RunPath(path);
 }
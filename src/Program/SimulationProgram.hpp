@@ -2,6 +2,10 @@
 #define SIMULATION_PROGRAM_HPP
 
 #include "../Helper/Program.hpp"
+#include "../Helper/Buffer.hpp"
+#include "../Helper/UniformBuffer.hpp"
+#include "../SPHSimulation/KernelParams.hpp"
+#include "../SPHSimulation/SimulationConfig.hpp"
 
 class SimulationState;
 
@@ -13,11 +17,56 @@ private:
 	GL::Program pressure;
 	GL::Program force;
 
+	// SolverPath::Packed 使用的 PACK_NEIGHBOURHOOD 变体
+	GL::Program packedPressure;
+	GL::Program packedForce;
+
+	SolverPath path;
+
+	// 两个计算阶段共用的平滑核参数块
+	GL::UniformBuffer kernelParamsBinding;
+	GL::Buffer kernelParamsBuffer;
+
+	// 驱动支持 GL_KHR_shader_subgroup 时使用子组归约的内核变体
+	bool subgroupReduction;
+
 	void CompileShaders();
+	void RunPath(SolverPath solverPath);
 public:
 	SimulationProgram(SimulationState& _state);
 
+	/**
+	 * @brief 上传新的平滑核参数，仅在参数改变时调用。
+	 */
+	void SetKernelParams(const SPH::KernelParams& params);
+
+	/**
+	 * @brief 让其他程序的 KernelParams 块读取同一份平滑核参数。
+	 */
+	void AttachKernelParams(const GL::Program& program) const;
+
+	inline bool UsesSubgroupReduction() const
+	{
+		return subgroupReduction;
+	}
+
+	inline void SetSolverPath(SolverPath solverPath)
+	{
+		path = solverPath;
+	}
+
+	inline SolverPath GetSolverPath() const
+	{
+		return path;
+	}
+
 	void Run();
+
+	/**
+	 * @brief 在当前已排序的状态上分别重复运行两条求解路径，用计时查询测量 GPU 耗时并输出日志。
+	 * @param iterations 每条路径计时的次数。
+	 */
+	void Benchmark(unsigned iterations);
 };
 
 #endif //GRID_PROGRAM_HPP
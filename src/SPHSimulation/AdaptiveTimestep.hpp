@@ -0,0 +1,65 @@
+/**
+ * @file AdaptiveTimestep.hpp
+ * @brief 根据 CFL 条件由粒子最大速率选取积分步长。
+ */
+
+#ifndef ADAPTIVE_TIMESTEP_HPP
+#define ADAPTIVE_TIMESTEP_HPP
+
+#include "SPHConstants.hpp"
+
+#include <algorithm>
+
+namespace SPH
+{
+
+/**
+ * @brief CFL 步长控制：dt = courant * h / vmax，限制在 [minDt, maxDt] 内。
+ *
+ * 步长可以立即缩小，但每次最多增长 MaxGrowth 倍。GPU 后端的最大速率落后若干步，
+ * 粒子在这几步里可能已经加速，缓慢增长避免了按过期的平静样本一下跳到大步长。
+ */
+class AdaptiveTimestep
+{
+private:
+	float courant;
+	float minDt;
+	float maxDt;
+
+	float current;
+public:
+	static constexpr float MaxGrowth = 1.25f;
+
+	/**
+	 * @param _courant CFL 数，每步粒子最多移动平滑半径的这一比例。
+	 * @param _minDt 步长下限（秒），防止剧烈阶段步长趋于 0。
+	 * @param _maxDt 步长上限（秒），静止时使用。
+	 */
+	AdaptiveTimestep(float _courant, float _minDt, float _maxDt) :
+		courant(_courant),
+		minDt(_minDt),
+		maxDt(_maxDt),
+		current(_minDt)
+	{
+	}
+
+	/**
+	 * @brief 由最近的最大速率求出下一步的步长并记为当前步长。
+	 * @param maxSpeed 粒子最大速率。
+	 */
+	inline float Next(float maxSpeed)
+	{
+		const float limit = maxSpeed > 0.0f ? courant * SmoothingLength / maxSpeed : maxDt;
+		current = std::clamp(std::min(limit, current * MaxGrowth), minDt, maxDt);
+		return current;
+	}
+
+	inline float Current() const
+	{
+		return current;
+	}
+};
+
+} // namespace SPH
+
+#endif //ADAPTIVE_TIMESTEP_HPP
@@ -0,0 +1,756 @@
+#include "CPUSimulation.hpp"
+
+#include "SPHConstants.hpp"
+#include "PredictiveCorrection.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+
+unsigned ResolveThreadCount(unsigned threadCount)
+{
+	if(threadCount != 0)
+		return threadCount;
+
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+inline float Poly6(const SPH::KernelParams& kernel, float rsquared)
+{
+	const float diff = kernel.smoothingLengthSquared - rsquared;
+
+	return kernel.poly6Coefficient * diff * diff * diff;
+}
+
+inline float Spiky(const SPH::KernelParams& kernel, float r)
+{
+	const float diff = kernel.smoothingLength - r;
+
+	return kernel.spikyCoefficient * diff * diff;
+}
+
+inline float ViscosityKernel(const SPH::KernelParams& kernel, float r)
+{
+	return kernel.viscosityCoefficient * (kernel.smoothingLength - r);
+}
+
+// Same reflection as basic.comp
+inline void Reflect(float& pos, float& vel)
+{
+	if(pos < -1.0f)
+	{
+		pos = -1.0f - SPH::Damping - SPH::Damping * pos;
+		vel = -SPH::Damping * vel;
+	}
+	if(pos > 1.0f)
+	{
+		pos = 1.0f + SPH::Damping - SPH::Damping * pos;
+		vel = -SPH::Damping * vel;
+	}
+}
+
+} //unnamed namespace
+
+CPUSimulation::CPUSimulation(const SimulationConfig& config) :
+	state(config),
+	pool(ResolveThreadCount(config.threads)),
+	kernel(SPH::DefaultKernelParams),
+	neighbourListsBuilt(false),
+	neighbourListBuilds(0),
+	truncatedNeighbourLists(0),
+	maxSpeed(0),
+	previousDt(0),
+	maxPressureIterations(config.pressureIterations),
+	densityTolerance(config.densityTolerance),
+	pressureIterations(0),
+	densityError(0)
+{
+}
+
+/**
+ * @brief 与 cellIndex.glsl 的 cellOfPosition 相同：哈希网格不限范围，其他方式截断到网格内。
+ */
+void CPUSimulation::CellCoordOf(const glm::vec3& position, int cell[3]) const
+{
+	const int res = static_cast<int>(state.GridRes());
+
+	for(int axis = 0; axis < 3; ++axis)
+	{
+		if(state.GetCellOrder() == SPH::CellOrder::Hashed)
+			cell[axis] = static_cast<int>(std::floor((position[axis] + 1.0f) * (0.5f * res)));
+		else
+			cell[axis] = std::clamp(static_cast<int>((position[axis] + 1.0f) * res) / 2, 0, res - 1);
+	}
+}
+
+/**
+ * @brief 求位置所在单元的编号，哈希网格中单元不存在时插入，与 count.comp 的 claimCell 相同。
+ */
+unsigned CPUSimulation::ClaimCell(const glm::vec3& position)
+{
+	int cell[3];
+	CellCoordOf(position, cell);
+
+	if(state.GetCellOrder() != SPH::CellOrder::Hashed)
+		return SPH::CellIndex(state.GetCellOrder(), state.GridRes(), cell[0], cell[1], cell[2]);
+
+	const unsigned key = SPH::PackCellKey(cell[0], cell[1], cell[2]);
+	const unsigned mask = state.CellSlotCount() - 1;
+	unsigned slot = SPH::CellHash(cell[0], cell[1], cell[2], state.CellSlotCount());
+
+	//There are at least as many slots as particles, so a free one is always found
+	for(unsigned probe = 0; probe < state.CellSlotCount(); ++probe)
+	{
+		unsigned stored = SPH::EmptyCellKey;
+		if(state.cellKey[slot].compare_exchange_strong(stored, key, std::memory_order_relaxed) || stored == key)
+			break;
+
+		slot = (slot + 1) & mask;
+	}
+
+	return slot;
+}
+
+/**
+ * @brief 查找单元的编号，单元在网格外或（哈希网格中）没有粒子时返回 false。
+ */
+bool CPUSimulation::FindCell(int x, int y, int z, unsigned& slot) const
+{
+	if(state.GetCellOrder() != SPH::CellOrder::Hashed)
+	{
+		const int res = static_cast<int>(state.GridRes());
+		if(x < 0 || y < 0 || z < 0 || x >= res || y >= res || z >= res)
+			return false;
+
+		slot = SPH::CellIndex(state.GetCellOrder(), res, x, y, z);
+		return true;
+	}
+
+	const unsigned key = SPH::PackCellKey(x, y, z);
+	const unsigned mask = state.CellSlotCount() - 1;
+	slot = SPH::CellHash(x, y, z, state.CellSlotCount());
+
+	for(unsigned probe = 0; probe < state.CellSlotCount(); ++probe)
+	{
+		const unsigned stored = state.cellKey[slot].load(std::memory_order_relaxed);
+		if(stored == key)
+			return true;
+		if(stored == SPH::EmptyCellKey)
+			return false;
+
+		slot = (slot + 1) & mask;
+	}
+
+	return false;
+}
+
+/**
+ * @brief 排序后位置所在单元的编号，该单元必然存在。
+ */
+unsigned CPUSimulation::CellOf(const glm::vec3& position) const
+{
+	int cell[3];
+	CellCoordOf(position, cell);
+
+	unsigned slot = 0;
+	FindCell(cell[0], cell[1], cell[2], slot);
+	return slot;
+}
+
+template<typename Visitor>
+void CPUSimulation::ForEachNeighbour(unsigned cell, Visitor&& visitor) const
+{
+	const SPH::CellCoord coord = state.GetCellOrder() == SPH::CellOrder::Hashed ?
+		SPH::UnpackCellKey(state.cellKey[cell].load(std::memory_order_relaxed)) :
+		SPH::DecodeCellIndex(state.GetCellOrder(), state.GridRes(), cell);
+	const int cellX = coord.x;
+	const int cellY = coord.y;
+	const int cellZ = coord.z;
+
+	for(int x = cellX - 1; x <= cellX + 1; ++x)
+	{
+		for(int y = cellY - 1; y <= cellY + 1; ++y)
+		{
+			for(int z = cellZ - 1; z <= cellZ + 1; ++z)
+			{
+				unsigned neighbour;
+				if(!FindCell(x, y, z, neighbour))
+					continue;
+
+				const unsigned end = state.cellOffset[neighbour + 1];
+				for(unsigned index = state.cellOffset[neighbour]; index < end; ++index)
+				{
+					visitor(index);
+				}
+			}
+		}
+	}
+}
+
+template<typename Visitor>
+void CPUSimulation::ForEachListedNeighbour(unsigned self, Visitor&& visitor) const
+{
+	const unsigned* list = &state.neighbourList[static_cast<std::size_t>(self) * state.neighbourCapacity];
+	for(unsigned k = 0; k < state.neighbourCount[self]; ++k)
+	{
+		visitor(list[k]);
+	}
+}
+
+void CPUSimulation::SortParticles()
+{
+	const std::vector<glm::vec3>& positions = state.Positions();
+	const unsigned particleCount = state.ParticleCount();
+
+	if(state.GetCellOrder() == SPH::CellOrder::Hashed)
+	{
+		for(std::atomic<unsigned>& key : state.cellKey)
+		{
+			key.store(SPH::EmptyCellKey, std::memory_order_relaxed);
+		}
+	}
+
+	pool.ParallelFor(particleCount, [&](std::size_t begin, std::size_t end)
+	{
+		for(std::size_t i = begin; i < end; ++i)
+		{
+			state.particleCell[i] = ClaimCell(positions[i]);
+		}
+	});
+
+	//Counting sort: histogram, exclusive prefix sum, stable scatter
+	std::vector<unsigned>& offset = state.cellOffset;
+	std::fill(offset.begin(), offset.end(), 0);
+
+	for(unsigned i = 0; i < particleCount; ++i)
+	{
+		++offset[state.particleCell[i] + 1];
+	}
+
+	for(unsigned cell = 0; cell < state.CellSlotCount(); ++cell)
+	{
+		offset[cell + 1] += offset[cell];
+	}
+
+	const unsigned forward = state.firstIsForward ? 0 : 1;
+	const unsigned back = 1 - forward;
+
+	std::vector<unsigned> cursor(offset.begin(), offset.end() - 1);
+	for(unsigned i = 0; i < particleCount; ++i)
+	{
+		const unsigned newIndex = cursor[state.particleCell[i]]++;
+		state.position[back][newIndex] = state.position[forward][i];
+		state.velocity[back][newIndex] = state.velocity[forward][i];
+	}
+
+	if(state.UsesPredictivePressure())
+	{
+		//Density overwrites pressure next, so it serves as scratch for the warm start permutation
+		cursor.assign(offset.begin(), offset.end() - 1);
+		for(unsigned i = 0; i < particleCount; ++i)
+		{
+			state.pressure[cursor[state.particleCell[i]]++] = state.previousPressure[i];
+		}
+		state.pressure.swap(state.previousPressure);
+	}
+
+	state.SwapBuffers();
+}
+
+void CPUSimulation::BuildNeighbourLists()
+{
+	const std::vector<glm::vec3>& positions = state.Positions();
+	const unsigned capacity = state.neighbourCapacity;
+
+	const float radius = kernel.smoothingLength + state.neighbourSkin;
+	const float radiusSquared = radius * radius;
+
+	std::atomic<unsigned> truncated(0);
+
+	pool.ParallelFor(state.ParticleCount(), [&](std::size_t begin, std::size_t end)
+	{
+		for(std::size_t self = begin; self < end; ++self)
+		{
+			const glm::vec3 selfPosition = positions[self];
+			unsigned* list = &state.neighbourList[self * capacity];
+
+			//Same candidates as neighbourBuild.comp, the particle itself included
+			unsigned count = 0;
+			ForEachNeighbour(CellOf(selfPosition), [&](unsigned other)
+			{
+				const glm::vec3 deltaPos = positions[other] - selfPosition;
+				if(glm::dot(deltaPos, deltaPos) < radiusSquared)
+				{
+					if(count < capacity)
+					{
+						list[count] = other;
+					}
+					++count;
+				}
+			});
+
+			if(count > capacity)
+			{
+				++truncated;
+			}
+
+			state.neighbourCount[self] = std::min(count, capacity);
+			state.referencePosition[self] = selfPosition;
+		}
+	});
+
+	neighbourListsBuilt = true;
+	++neighbourListBuilds;
+	truncatedNeighbourLists = truncated;
+}
+
+bool CPUSimulation::NeighbourListsExpired() const
+{
+	if(!neighbourListsBuilt)
+		return true;
+
+	//Exact here, the GPU path has to extrapolate from a lagging readback
+	const std::vector<glm::vec3>& positions = state.Positions();
+	const float limitSquared = state.neighbourSkin * state.neighbourSkin / 4;
+	for(unsigned i = 0; i < state.ParticleCount(); ++i)
+	{
+		const glm::vec3 displacement = positions[i] - state.referencePosition[i];
+		if(glm::dot(displacement, displacement) > limitSquared)
+			return true;
+	}
+
+	return false;
+}
+
+template<typename ForEachOther>
+void CPUSimulation::ComputeParticleDensity(unsigned self, ForEachOther&& forEachOther)
+{
+	const std::vector<glm::vec3>& positions = state.Positions();
+	const glm::vec3 selfPosition = positions[self];
+
+	float selfDensity = 0;
+
+	const auto addNeighbour = [&](const glm::vec3& otherPosition)
+	{
+		const glm::vec3 deltaPos = otherPosition - selfPosition;
+		const float rsquared = glm::dot(deltaPos, deltaPos);
+		if(rsquared < kernel.smoothingLengthSquared)
+		{
+			selfDensity += Poly6(kernel, rsquared);
+		}
+	};
+
+	//Mirror images only count with PCISPH, the same density feeds its pressure force
+	const SPH::WallMirror mirror = state.UsesPredictivePressure() ? SPH::MakeWallMirror(kernel, selfPosition) : SPH::WallMirror{};
+
+	forEachOther([&](unsigned other)
+	{
+		addNeighbour(positions[other]);
+		SPH::ForEachMirrorImage(mirror, positions[other], addNeighbour);
+	});
+
+	selfDensity *= kernel.mass;
+
+	state.density[self] = std::max(selfDensity, SPH::MinDensity);
+	state.pressure[self] = std::max(kernel.stiffness * (selfDensity - kernel.restDensity), 0.0f);
+}
+
+template<typename ForEachOther>
+void CPUSimulation::ComputeParticleForce(unsigned self, ForEachOther&& forEachOther)
+{
+	const std::vector<glm::vec3>& positions = state.Positions();
+	const std::vector<glm::vec3>& velocities = state.Velocities();
+
+	const glm::vec3 selfPosition = positions[self];
+	const glm::vec3 selfVelocity = velocities[self];
+	const float selfPressure = state.pressure[self];
+
+	glm::vec3 pressureForce(0, 0, 0);
+	glm::vec3 viscosityForce(0, 0, 0);
+
+	forEachOther([&](unsigned other)
+	{
+		const glm::vec3 deltaPos = positions[other] - selfPosition;
+		const float r = glm::length(deltaPos);
+		if(r > SPH::MinDistance && r < kernel.smoothingLength)
+		{
+			const float densityInv = 1.0f / state.density[other];
+
+			pressureForce -=
+				kernel.mass * (state.pressure[other] + selfPressure) * 0.5f * densityInv *
+				Spiky(kernel, r) * (deltaPos / r);
+
+			viscosityForce +=
+				kernel.mass * (velocities[other] - selfVelocity) * densityInv *
+				ViscosityKernel(kernel, r);
+		}
+	});
+
+	state.force[self] = pressureForce + kernel.viscosity * viscosityForce;
+}
+
+void CPUSimulation::ComputeDensity()
+{
+	if(state.UsesNeighbourLists())
+	{
+		pool.ParallelFor(state.ParticleCount(), [&](std::size_t begin, std::size_t end)
+		{
+			for(std::size_t self = begin; self < end; ++self)
+			{
+				ComputeParticleDensity(self, [&](auto&& visitor) { ForEachListedNeighbour(self, visitor); });
+			}
+		});
+		return;
+	}
+
+	pool.ParallelFor(state.CellSlotCount(), [&](std::size_t beginCell, std::size_t endCell)
+	{
+		for(std::size_t cell = beginCell; cell < endCell; ++cell)
+		{
+			for(unsigned self = state.cellOffset[cell]; self < state.cellOffset[cell + 1]; ++self)
+			{
+				ComputeParticleDensity(self, [&](auto&& visitor) { ForEachNeighbour(cell, visitor); });
+			}
+		}
+	});
+}
+
+void CPUSimulation::ComputeForce()
+{
+	if(state.UsesNeighbourLists())
+	{
+		pool.ParallelFor(state.ParticleCount(), [&](std::size_t begin, std::size_t end)
+		{
+			for(std::size_t self = begin; self < end; ++self)
+			{
+				ComputeParticleForce(self, [&](auto&& visitor) { ForEachListedNeighbour(self, visitor); });
+			}
+		});
+		return;
+	}
+
+	pool.ParallelFor(state.CellSlotCount(), [&](std::size_t beginCell, std::size_t endCell)
+	{
+		for(std::size_t cell = beginCell; cell < endCell; ++cell)
+		{
+			for(unsigned self = state.cellOffset[cell]; self < state.cellOffset[cell + 1]; ++self)
+			{
+				ComputeParticleForce(self, [&](auto&& visitor) { ForEachNeighbour(cell, visitor); });
+			}
+		}
+	});
+}
+
+void CPUSimulation::SolvePressure(const StepParams& params)
+{
+	//With zero pressure the force pass leaves only viscosity, the pressure force is kept apart
+	std::fill(state.pressure.begin(), state.pressure.end(), 0.0f);
+	ComputeForce();
+
+	//Start from the previous step's pressure, rebuilding the hydrostatic pressure from zero every step never converges
+	state.pressure = state.previousPressure;
+	ComputePressureForce();
+
+	const float inverseDtSquared = 1.0f / (params.dt * params.dt);
+
+	pressureIterations = 0;
+	do
+	{
+		PredictPositions(params);
+		densityError = CorrectPressure(inverseDtSquared);
+		ComputePressureForce();
+		++pressureIterations;
+	}
+	while(pressureIterations < maxPressureIterations &&
+		(pressureIterations < SPH::MinPressureIterations || densityError > densityTolerance));
+
+	state.previousPressure = state.pressure;
+
+	pool.ParallelFor(state.ParticleCount(), [&](std::size_t begin, std::size_t end)
+	{
+		for(std::size_t id = begin; id < end; ++id)
+		{
+			state.force[id] += state.pressureForce[id];
+		}
+	});
+}
+
+void CPUSimulation::PredictPositions(const StepParams& params)
+{
+	const std::vector<glm::vec3>& positions = state.Positions();
+	const std::vector<glm::vec3>& velocities = state.Velocities();
+
+	pool.ParallelFor(state.ParticleCount(), [&](std::size_t begin, std::size_t end)
+	{
+		for(std::size_t id = begin; id < end; ++id)
+		{
+			const glm::vec3 acceleration =
+				(state.force[id] + state.pressureForce[id]) / state.density[id] + params.gravityDir * SPH::Gravity;
+			glm::vec3 vel = velocities[id] + acceleration * params.dt;
+			glm::vec3 pos = positions[id] + vel * params.dt;
+
+			//Same walls as Integrate, clamping would stack particles on the wall and inflate their density
+			for(int axis = 0; axis < 3; ++axis)
+			{
+				Reflect(pos[axis], vel[axis]);
+			}
+
+			state.predictedPosition[id] = pos;
+		}
+	});
+}
+
+float CPUSimulation::CorrectPressure(float inverseDtSquared)
+{
+	const std::vector<glm::vec3>& predicted = state.predictedPosition;
+
+	std::mutex errorMutex;
+	float maxError = 0;
+
+	//Neighbours are searched in the cells of the current positions, as in the GPU kernels
+	pool.ParallelFor(state.CellSlotCount(), [&](std::size_t beginCell, std::size_t endCell)
+	{
+		float chunkError = 0;
+
+		for(std::size_t cell = beginCell; cell < endCell; ++cell)
+		{
+			for(unsigned self = state.cellOffset[cell]; self < state.cellOffset[cell + 1]; ++self)
+			{
+				const glm::vec3 selfPosition = predicted[self];
+
+				float selfDensity = 0;
+				glm::vec3 gradientSum(0);
+				float gradientSquaredSum = 0;
+				const auto addNeighbour = [&](const glm::vec3& otherPosition)
+				{
+					const glm::vec3 deltaPos = otherPosition - selfPosition;
+					const float rsquared = glm::dot(deltaPos, deltaPos);
+					if(rsquared < kernel.smoothingLengthSquared)
+					{
+						selfDensity += Poly6(kernel, rsquared);
+						const float r = std::sqrt(rsquared);
+						if(r > SPH::MinDistance)
+						{
+							const glm::vec3 gradient = Spiky(kernel, r) * deltaPos / r;
+							gradientSum += gradient;
+							gradientSquaredSum += glm::dot(gradient, gradient);
+						}
+					}
+				};
+
+				//Mirror images count as ordinary neighbours, so wall particles see a full neighbourhood
+				const SPH::WallMirror mirror = SPH::MakeWallMirror(kernel, selfPosition);
+				ForEachNeighbour(cell, [&](unsigned other)
+				{
+					addNeighbour(predicted[other]);
+					SPH::ForEachMirrorImage(mirror, predicted[other], addNeighbour);
+				});
+
+				const float error = kernel.mass * selfDensity - kernel.restDensity;
+				const float factor = SPH::PredictiveCorrectionFactor(kernel, glm::dot(gradientSum, gradientSum), gradientSquaredSum);
+				state.pressure[self] = std::max(state.pressure[self] + factor * inverseDtSquared * error, 0.0f);
+
+				chunkError = std::max(chunkError, error);
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(errorMutex);
+		maxError = std::max(maxError, chunkError);
+	});
+
+	return maxError / kernel.restDensity;
+}
+
+void CPUSimulation::ComputePressureForce()
+{
+	const std::vector<glm::vec3>& positions = state.Positions();
+
+	pool.ParallelFor(state.CellSlotCount(), [&](std::size_t beginCell, std::size_t endCell)
+	{
+		for(std::size_t cell = beginCell; cell < endCell; ++cell)
+		{
+			for(unsigned self = state.cellOffset[cell]; self < state.cellOffset[cell + 1]; ++self)
+			{
+				const glm::vec3 selfPosition = positions[self];
+				const float selfPressure = state.pressure[self];
+
+				glm::vec3 pressureForce(0, 0, 0);
+				const SPH::WallMirror mirror = SPH::MakeWallMirror(kernel, selfPosition);
+				ForEachNeighbour(cell, [&](unsigned other)
+				{
+					//Mirror images carry the pressure and density of the particle they mirror
+					const auto addNeighbour = [&](const glm::vec3& otherPosition)
+					{
+						const glm::vec3 deltaPos = otherPosition - selfPosition;
+						const float r = glm::length(deltaPos);
+						if(r > SPH::MinDistance && r < kernel.smoothingLength)
+						{
+							pressureForce -=
+								kernel.mass * (state.pressure[other] + selfPressure) * 0.5f / state.density[other] *
+								Spiky(kernel, r) * (deltaPos / r);
+						}
+					};
+
+					addNeighbour(positions[other]);
+					SPH::ForEachMirrorImage(mirror, positions[other], addNeighbour);
+				});
+
+				state.pressureForce[self] = pressureForce;
+			}
+		}
+	});
+}
+
+void CPUSimulation::Integrate(const StepParams& params)
+{
+	const unsigned forward = state.firstIsForward ? 0 : 1;
+	std::vector<glm::vec3>& positions = state.position[forward];
+	std::vector<glm::vec3>& velocities = state.velocity[forward];
+
+	//Same kicks as basic.comp, after Euler steps leapfrog restarts with a half kick
+	const bool leapfrog = params.integrator == Integrator::Leapfrog;
+	const float kick = leapfrog ? 0.5f * (previousDt + params.dt) : params.dt;
+	previousDt = leapfrog ? params.dt : 0.0f;
+
+	//Each chunk reduces its own maximum, like the per-group reduction in basic.comp
+	std::mutex speedMutex;
+	maxSpeed = 0;
+
+	pool.ParallelFor(state.ParticleCount(), [&](std::size_t begin, std::size_t end)
+	{
+		float chunkSpeed = 0;
+
+		for(std::size_t id = begin; id < end; ++id)
+		{
+			const glm::vec3 acceleration = state.force[id] / state.density[id] + params.gravityDir * SPH::Gravity;
+			glm::vec3 vel = velocities[id] + acceleration * kick;
+			glm::vec3 pos = positions[id] + vel * params.dt;
+
+			if(params.obstacleEnabled)
+			{
+				const float dist = glm::length(pos);
+				if(dist < params.obstacleRadius)
+				{
+					const glm::vec3 n = dist > 0.0f ? pos / dist : glm::vec3(0, 1, 0);
+					pos = n * params.obstacleRadius;
+					const float vn = glm::dot(vel, n);
+					vel = vel - (1.0f + SPH::Damping) * vn * n;
+					vel *= 0.95f;
+				}
+			}
+
+			for(int axis = 0; axis < 3; ++axis)
+			{
+				Reflect(pos[axis], vel[axis]);
+			}
+
+			velocities[id] = vel;
+			positions[id] = pos;
+
+			chunkSpeed = std::max(chunkSpeed, glm::length(vel));
+		}
+
+		std::lock_guard<std::mutex> lock(speedMutex);
+		maxSpeed = std::max(maxSpeed, chunkSpeed);
+	});
+}
+
+template<typename ForEachOther>
+void CPUSimulation::MarkEdge(unsigned self, ForEachOther&& forEachOther)
+{
+	const std::vector<glm::vec3>& positions = state.Positions();
+	const glm::vec3 selfPosition = positions[self];
+
+	float neighbourCount = 0;
+	glm::vec3 centerSum(0, 0, 0);
+
+	forEachOther([&](unsigned other)
+	{
+		const glm::vec3 deltaPos = positions[other] - selfPosition;
+		if(glm::dot(deltaPos, deltaPos) < kernel.smoothingLengthSquared)
+		{
+			neighbourCount += 1;
+			centerSum += deltaPos;
+		}
+	});
+
+	state.edgeFlag[self] =
+		neighbourCount < SPH::EdgeMinNeighbours ||
+		glm::length(centerSum / neighbourCount) > SPH::EdgeThreshold;
+}
+
+void CPUSimulation::ExtractEdges()
+{
+	//Same neighbourhoods as the last step's density pass, the particles have been integrated since
+	if(state.UsesNeighbourLists())
+	{
+		pool.ParallelFor(state.ParticleCount(), [&](std::size_t begin, std::size_t end)
+		{
+			for(std::size_t self = begin; self < end; ++self)
+			{
+				MarkEdge(self, [&](auto&& visitor) { ForEachListedNeighbour(self, visitor); });
+			}
+		});
+	}
+	else
+	{
+		pool.ParallelFor(state.CellSlotCount(), [&](std::size_t beginCell, std::size_t endCell)
+		{
+			for(std::size_t cell = beginCell; cell < endCell; ++cell)
+			{
+				for(unsigned self = state.cellOffset[cell]; self < state.cellOffset[cell + 1]; ++self)
+				{
+					MarkEdge(self, [&](auto&& visitor) { ForEachNeighbour(cell, visitor); });
+				}
+			}
+		});
+	}
+
+	CollectEdges();
+}
+
+void CPUSimulation::CollectEdges()
+{
+	const std::vector<glm::vec3>& positions = state.Positions();
+
+	state.edgePosition.clear();
+	for(unsigned i = 0; i < state.ParticleCount(); ++i)
+	{
+		if(state.edgeFlag[i])
+		{
+			state.edgePosition.push_back(positions[i]);
+		}
+	}
+}
+
+void CPUSimulation::Step(const StepParams& params)
+{
+	if(!state.UsesNeighbourLists())
+	{
+		SortParticles();
+	}
+	else if(NeighbourListsExpired())
+	{
+		//Lists hold sorted indices, so the sort only runs together with a rebuild
+		SortParticles();
+		BuildNeighbourLists();
+	}
+
+	ComputeDensity();
+	if(state.UsesPredictivePressure())
+	{
+		SolvePressure(params);
+	}
+	else
+	{
+		ComputeForce();
+	}
+	Integrate(params);
+}
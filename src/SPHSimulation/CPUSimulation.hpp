@@ -0,0 +1,158 @@
+/**
+ * @file CPUSimulation.hpp
+ * @brief 声明 SPH 单步的多线程 CPU 参考实现。
+ */
+
+#ifndef CPU_SIMULATION_HPP
+#define CPU_SIMULATION_HPP
+
+#include "SimulationBackend.hpp"
+#include "CPUSimulationState.hpp"
+#include "SimulationConfig.hpp"
+#include "KernelParams.hpp"
+
+#include "../Helper/ThreadPool.hpp"
+
+/**
+ * @brief 不依赖 OpenGL 的 SPH 后端，逐阶段复现 GridProgram、SimulationProgram 与 basic.comp。
+ *
+ * 密度与受力按网格单元并行，单元内的粒子在排序后是连续的。
+ * 启用邻居表时与 NeighbourListProgram 相同：只在位移超过 skin 一半时排序并重建，其余步按粒子并行遍历邻居表。
+ * 使用 PCISPH 时与 PressureSolverProgram 相同：受力阶段只求粘性力，压强由预测-修正迭代得到。
+ */
+class CPUSimulation : public SimulationBackend
+{
+private:
+	CPUSimulationState state;
+	ThreadPool pool;
+
+	SPH::KernelParams kernel;
+
+	bool neighbourListsBuilt;
+	unsigned neighbourListBuilds;
+	unsigned truncatedNeighbourLists;
+
+	float maxSpeed;
+
+	// 上一个蛙跳步的步长，上一步不是蛙跳时为 0
+	float previousDt;
+
+	// PressureSolver::Predictive 的参数与最近一步的迭代统计
+	unsigned maxPressureIterations;
+	float densityTolerance;
+	unsigned pressureIterations;
+	float densityError;
+
+	void CellCoordOf(const glm::vec3& position, int cell[3]) const;
+	unsigned ClaimCell(const glm::vec3& position);
+	bool FindCell(int x, int y, int z, unsigned& slot) const;
+	unsigned CellOf(const glm::vec3& position) const;
+
+	void SortParticles();
+	void BuildNeighbourLists();
+	bool NeighbourListsExpired() const;
+	void ComputeDensity();
+	void ComputeForce();
+	void Integrate(const StepParams& params);
+	void SolvePressure(const StepParams& params);
+	void PredictPositions(const StepParams& params);
+	float CorrectPressure(float inverseDtSquared);
+	void ComputePressureForce();
+	void CollectEdges();
+
+	template<typename Visitor>
+	void ForEachNeighbour(unsigned cell, Visitor&& visitor) const;
+
+	template<typename Visitor>
+	void ForEachListedNeighbour(unsigned self, Visitor&& visitor) const;
+
+	// forEachOther(visitor) 对 self 的每个候选邻居调用 visitor(other)
+	template<typename ForEachOther>
+	void ComputeParticleDensity(unsigned self, ForEachOther&& forEachOther);
+
+	template<typename ForEachOther>
+	void ComputeParticleForce(unsigned self, ForEachOther&& forEachOther);
+
+	template<typename ForEachOther>
+	void MarkEdge(unsigned self, ForEachOther&& forEachOther);
+public:
+	/**
+	 * @brief 构造 CPU 后端。
+	 * @param config 模拟配置，config.threads 为 0 时使用硬件线程数。
+	 */
+	CPUSimulation(const SimulationConfig& config);
+
+	virtual void Step(const StepParams& params) override;
+
+	virtual float MaxSpeed() override
+	{
+		return maxSpeed;
+	}
+
+	/**
+	 * @brief 与 edgeExtract.comp 相同，结果写入 State().EdgePositions()。
+	 */
+	virtual void ExtractEdges() override;
+
+	/**
+	 * @brief 替换平滑核参数，与 SimulationProgram::SetKernelParams 对应。
+	 */
+	void SetKernelParams(const SPH::KernelParams& params)
+	{
+		kernel = params;
+	}
+
+	virtual const CPUSimulationState* HostState() const override
+	{
+		return &state;
+	}
+
+	virtual Type GetType() const override
+	{
+		return Type::CPU;
+	}
+
+	const CPUSimulationState& State() const
+	{
+		return state;
+	}
+
+	unsigned ThreadCount() const
+	{
+		return pool.Size();
+	}
+
+	/**
+	 * @brief 最近一步 PCISPH 压强迭代的次数，未启用时为 0。
+	 */
+	unsigned PressureIterations() const
+	{
+		return pressureIterations;
+	}
+
+	/**
+	 * @brief 最近一步 PCISPH 迭代结束时预测密度超出静止密度的最大相对误差。
+	 */
+	float DensityError() const
+	{
+		return densityError;
+	}
+
+	/**
+	 * @brief 邻居表（连同粒子排序）被重建的次数。
+	 */
+	unsigned NeighbourListBuilds() const
+	{
+		return neighbourListBuilds;
+	}
+
+	/**
+	 * @brief 最近一次重建时邻居数超过容量而被截断的粒子数。
+	 */
+	unsigned TruncatedNeighbourLists() const
+	{
+		return truncatedNeighbourLists;
+	}
+};
+
+#endif //CPU_SIMULATION_HPP
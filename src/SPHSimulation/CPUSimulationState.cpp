@@ -0,0 +1,59 @@
+#include "CPUSimulationState.hpp"
+
+#include "ParticleBlock.hpp"
+#include "SimulationConfig.hpp"
+
+CPUSimulationState::CPUSimulationState(const SimulationConfig& config) :
+	resX(config.resX),
+	resY(config.resY),
+	resZ(config.resZ),
+	gridResolution(config.gridResolution),
+	cellOrder(config.cellOrder),
+	cellSlots(config.CellSlotCount()),
+	neighbourSkin(config.neighbourSkin),
+	neighbourCapacity(config.neighbourCapacity),
+	predictivePressure(config.pressureSolver == PressureSolver::Predictive),
+	firstIsForward(true)
+{
+	const unsigned count = ParticleCount();
+
+	position[0] = MakeParticleBlock(resX, resY, resZ, config.particleSpacing);
+	position[1].resize(count);
+
+	velocity[0].assign(count, glm::vec3(0, 0, 0));
+	velocity[1].resize(count);
+
+	density.assign(count, 0);
+	pressure.assign(count, 0);
+	force.assign(count, glm::vec3(0, 0, 0));
+
+	particleCell.resize(count);
+	cellOffset.assign(CellSlotCount() + 1, 0);
+
+	if(cellOrder == SPH::CellOrder::Hashed)
+	{
+		cellKey = std::vector<std::atomic<unsigned>>(CellSlotCount());
+	}
+
+	edgeFlag.assign(count, 0);
+	edgePosition.reserve(count);
+
+	if(UsesNeighbourLists())
+	{
+		referencePosition.resize(count);
+		neighbourCount.assign(count, 0);
+		neighbourList.resize(static_cast<std::size_t>(count) * neighbourCapacity);
+	}
+
+	if(UsesPredictivePressure())
+	{
+		predictedPosition.resize(count);
+		pressureForce.assign(count, glm::vec3(0, 0, 0));
+		previousPressure.assign(count, 0);
+	}
+}
+
+void CPUSimulationState::SwapBuffers()
+{
+	firstIsForward = !firstIsForward;
+}
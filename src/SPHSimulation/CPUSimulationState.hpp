@@ -0,0 +1,171 @@
+/**
+ * @file CPUSimulationState.hpp
+ * @brief 声明位于主存中的粒子状态，是 SimulationState 的无 GL 对应物。
+ */
+
+#ifndef CPU_SIMULATION_STATE_HPP
+#define CPU_SIMULATION_STATE_HPP
+
+#include "CellIndex.hpp"
+
+#include <glm/vec3.hpp>
+
+#include <atomic>
+#include <vector>
+
+struct SimulationConfig;
+
+/**
+ * @brief CPU 后端的粒子数据，布局与访问接口尽量与 SimulationState 保持一致。
+ *
+ * 位置与速度双缓冲：网格排序把前向缓冲按单元顺序写入后向缓冲后交换。
+ */
+class CPUSimulationState
+{
+private:
+	std::vector<glm::vec3> position[2];
+	std::vector<glm::vec3> velocity[2];
+
+	std::vector<float> density;
+	std::vector<float> pressure;
+	std::vector<glm::vec3> force;
+
+	// 每个粒子的单元编号，以及每个单元的起始偏移（长度为单元编号范围 + 1）
+	std::vector<unsigned> particleCell;
+	std::vector<unsigned> cellOffset;
+
+	// CellOrder::Hashed 的哈希表：每个槽位所存单元的键，排序时由各线程并发插入
+	std::vector<std::atomic<unsigned>> cellKey;
+
+	std::vector<unsigned char> edgeFlag;
+	std::vector<glm::vec3> edgePosition;
+
+	// Verlet 邻居表：构建时的位置、每个粒子的邻居数，以及按 i * 容量 + k 连续存放的邻居编号
+	std::vector<glm::vec3> referencePosition;
+	std::vector<unsigned> neighbourCount;
+	std::vector<unsigned> neighbourList;
+
+	// PressureSolver::Predictive 的预测位置与压强力，受力数组此时只含粘性力
+	std::vector<glm::vec3> predictedPosition;
+	std::vector<glm::vec3> pressureForce;
+	// 上一步迭代结束时的压强，随排序一起重排，作为下一步迭代的初值
+	std::vector<float> previousPressure;
+
+	const unsigned resX;
+	const unsigned resY;
+	const unsigned resZ;
+
+	const unsigned gridResolution;
+	const SPH::CellOrder cellOrder;
+	const unsigned cellSlots;
+
+	const float neighbourSkin;
+	const unsigned neighbourCapacity;
+
+	const bool predictivePressure;
+
+	bool firstIsForward;
+
+	friend class CPUSimulation;
+public:
+	CPUSimulationState(const SimulationConfig& config);
+
+	void SwapBuffers();
+
+	inline const std::vector<glm::vec3>& Positions() const
+	{
+		return position[firstIsForward ? 0 : 1];
+	}
+
+	inline const std::vector<glm::vec3>& Velocities() const
+	{
+		return velocity[firstIsForward ? 0 : 1];
+	}
+
+	inline const std::vector<float>& Densities() const
+	{
+		return density;
+	}
+
+	inline const std::vector<float>& Pressures() const
+	{
+		return pressure;
+	}
+
+	inline const std::vector<glm::vec3>& Forces() const
+	{
+		return force;
+	}
+
+	inline const std::vector<unsigned>& CellOffsets() const
+	{
+		return cellOffset;
+	}
+
+	inline const std::vector<glm::vec3>& EdgePositions() const
+	{
+		return edgePosition;
+	}
+
+	inline unsigned GetEdgeCount() const
+	{
+		return static_cast<unsigned>(edgePosition.size());
+	}
+
+	inline unsigned ResX() const
+	{
+		return resX;
+	}
+
+	inline unsigned ResY() const
+	{
+		return resY;
+	}
+
+	inline unsigned ResZ() const
+	{
+		return resZ;
+	}
+
+	inline unsigned GridRes() const
+	{
+		return gridResolution;
+	}
+
+	inline unsigned ParticleCount() const
+	{
+		return resX * resY * resZ;
+	}
+
+	inline unsigned CellCount() const
+	{
+		return gridResolution * gridResolution * gridResolution;
+	}
+
+	inline unsigned CellSlotCount() const
+	{
+		return cellSlots;
+	}
+
+	inline SPH::CellOrder GetCellOrder() const
+	{
+		return cellOrder;
+	}
+
+	inline bool UsesNeighbourLists() const
+	{
+		return neighbourSkin > 0.0f;
+	}
+
+	inline float NeighbourSkin() const
+	{
+		return neighbourSkin;
+	}
+
+	inline bool UsesPredictivePressure() const
+	{
+		return predictivePressure;
+	}
+};
+
+#endif //CPU_SIMULATION_STATE_HPP
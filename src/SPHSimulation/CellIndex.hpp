@@ -0,0 +1,152 @@
+/**
+ * @file CellIndex.hpp
+ * @brief 网格单元坐标与一维单元编号之间的换算，CPU 后端与 shaders/Grid/cellIndex.glsl 使用同一套规则。
+ */
+
+#ifndef CELL_INDEX_HPP
+#define CELL_INDEX_HPP
+
+namespace SPH
+{
+
+/**
+ * @brief 单元编号的排列方式。
+ */
+enum class CellOrder
+{
+	// x * R * R + y * R + z
+	Linear,
+	// 三个坐标按位交错（Z 序），相邻单元的编号也相邻
+	Morton,
+	// 固定大小的空间哈希表，线性探测解决冲突，只有非空单元占用槽位，单元坐标不受 [-1, 1] 限制
+	Hashed,
+};
+
+// Morton 编码每个坐标占 10 位
+constexpr unsigned MaxMortonResolution = 1024;
+
+// 哈希表的键每轴取坐标的低 10 位，相距 HashedAxisPeriod 个单元的两个单元会共用一个槽位
+constexpr unsigned HashedAxisBits = 10;
+constexpr unsigned HashedAxisPeriod = 1u << HashedAxisBits;
+
+// 空槽位的键，有效键只占低 30 位
+constexpr unsigned EmptyCellKey = 0xFFFFFFFF;
+
+/**
+ * @brief 单元的三维整数坐标。
+ */
+struct CellCoord
+{
+	unsigned x;
+	unsigned y;
+	unsigned z;
+};
+
+/**
+ * @brief 把 10 位整数的每一位之间插入两个 0 位。
+ */
+inline unsigned SpreadBits(unsigned v)
+{
+	v &= 0x000003FF;
+	v = (v | (v << 16)) & 0x030000FF;
+	v = (v | (v << 8)) & 0x0300F00F;
+	v = (v | (v << 4)) & 0x030C30C3;
+	v = (v | (v << 2)) & 0x09249249;
+	return v;
+}
+
+/**
+ * @brief SpreadBits 的逆运算，取出每隔两位的一位。
+ */
+inline unsigned CompactBits(unsigned v)
+{
+	v &= 0x09249249;
+	v = (v | (v >> 2)) & 0x030C30C3;
+	v = (v | (v >> 4)) & 0x0300F00F;
+	v = (v | (v >> 8)) & 0x030000FF;
+	v = (v | (v >> 16)) & 0x000003FF;
+	return v;
+}
+
+/**
+ * @brief 单元编号的取值范围，即网格缓冲与单元偏移数组所需的长度。
+ *
+ * Morton 编号要求每轴为 2 的幂，分辨率会向上取整，多出的编号永远为空单元。
+ * 哈希网格的编号即哈希表槽位，数量与分辨率无关。
+ * @param hashSlots CellOrder::Hashed 的槽位数，其他方式忽略。
+ */
+inline unsigned CellSlotCount(CellOrder order, unsigned resolution, unsigned hashSlots)
+{
+	if(order == CellOrder::Hashed)
+		return hashSlots;
+
+	if(order == CellOrder::Morton)
+	{
+		unsigned size = 1;
+		while(size < resolution)
+			size <<= 1;
+		return size * size * size;
+	}
+
+	return resolution * resolution * resolution;
+}
+
+/**
+ * @brief 由单元坐标求一维编号。
+ */
+inline unsigned CellIndex(CellOrder order, unsigned resolution, unsigned x, unsigned y, unsigned z)
+{
+	if(order == CellOrder::Morton)
+		return (SpreadBits(x) << 2) | (SpreadBits(y) << 1) | SpreadBits(z);
+
+	return x * resolution * resolution + y * resolution + z;
+}
+
+/**
+ * @brief 由一维编号还原单元坐标。
+ */
+inline CellCoord DecodeCellIndex(CellOrder order, unsigned resolution, unsigned index)
+{
+	if(order == CellOrder::Morton)
+		return CellCoord{CompactBits(index >> 2), CompactBits(index >> 1), CompactBits(index)};
+
+	return CellCoord{index / (resolution * resolution), (index / resolution) % resolution, index % resolution};
+}
+
+/**
+ * @brief 哈希网格中单元坐标的键，每轴取低 HashedAxisBits 位，负坐标按补码回绕。
+ */
+inline unsigned PackCellKey(int x, int y, int z)
+{
+	const unsigned mask = HashedAxisPeriod - 1;
+	return ((static_cast<unsigned>(x) & mask) << (2 * HashedAxisBits)) |
+		((static_cast<unsigned>(y) & mask) << HashedAxisBits) |
+		(static_cast<unsigned>(z) & mask);
+}
+
+/**
+ * @brief PackCellKey 的逆运算，得到回绕到 [0, HashedAxisPeriod) 内的坐标。
+ *
+ * 邻居坐标由它加减 1 后重新求键，回绕前后的键一致。
+ */
+inline CellCoord UnpackCellKey(unsigned key)
+{
+	const unsigned mask = HashedAxisPeriod - 1;
+	return CellCoord{(key >> (2 * HashedAxisBits)) & mask, (key >> HashedAxisBits) & mask, key & mask};
+}
+
+/**
+ * @brief 单元在哈希表中的起始探测槽位（Teschner 等人的空间哈希）。
+ * @param slots 槽位数，必须是 2 的幂。
+ */
+inline unsigned CellHash(int x, int y, int z, unsigned slots)
+{
+	const unsigned mask = HashedAxisPeriod - 1;
+	return (((static_cast<unsigned>(x) & mask) * 73856093u) ^
+		((static_cast<unsigned>(y) & mask) * 19349663u) ^
+		((static_cast<unsigned>(z) & mask) * 83492791u)) & (slots - 1);
+}
+
+} //namespace SPH
+
+#endif //CELL_INDEX_HPP
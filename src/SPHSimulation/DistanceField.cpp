@@ -0,0 +1,209 @@
+/**
+ * @file DistanceField.cpp
+ * @brief 跳跃泛洪距离场与逐粒子参考实现。
+ */
+
+#include "DistanceField.hpp"
+
+#include "../Helper/ThreadPool.hpp"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+
+inline std::size_t VoxelIndex(int x, int y, int z, int size)
+{
+	return (static_cast<std::size_t>(z) * size + y) * size + x;
+}
+
+inline bool InField(int x, int y, int z, int size)
+{
+	return x >= 0 && y >= 0 && z >= 0 && x < size && y < size && z < size;
+}
+
+inline float Distance(const glm::vec3& voxel, int x, int y, int z)
+{
+	return glm::length(voxel - glm::vec3(x, y, z));
+}
+
+/**
+ * @brief 一次传播：每个体素在 27 个相距 step 的体素的种子中取最近的一个，距离相同取下标小的。
+ */
+void JumpFloodPass(const std::vector<glm::vec3>& voxels, const std::vector<unsigned>& source, std::vector<unsigned>& target,
+	int size, int step, ThreadPool& pool)
+{
+	pool.ParallelFor(static_cast<std::size_t>(size) * size, [&](std::size_t begin, std::size_t end)
+	{
+		for(std::size_t row = begin; row < end; ++row)
+		{
+			const int z = static_cast<int>(row / size);
+			const int y = static_cast<int>(row % size);
+
+			for(int x = 0; x < size; ++x)
+			{
+				unsigned best = SPH::NoSeed;
+				float bestDistance = 0;
+
+				for(int dz = -step; dz <= step; dz += step)
+				{
+					for(int dy = -step; dy <= step; dy += step)
+					{
+						for(int dx = -step; dx <= step; dx += step)
+						{
+							const int sx = x + dx;
+							const int sy = y + dy;
+							const int sz = z + dz;
+							if(!InField(sx, sy, sz, size))
+								continue;
+
+							const unsigned seed = source[VoxelIndex(sx, sy, sz, size)];
+							if(seed == SPH::NoSeed)
+								continue;
+
+							const float distance = Distance(voxels[seed], x, y, z);
+							if(best == SPH::NoSeed || distance < bestDistance || (distance == bestDistance && seed < best))
+							{
+								best = seed;
+								bestDistance = distance;
+							}
+						}
+					}
+				}
+
+				target[VoxelIndex(x, y, z, size)] = best;
+			}
+		}
+	});
+}
+
+} //unnamed namespace
+
+namespace SPH
+{
+
+std::vector<float> JumpFloodDistanceField(const std::vector<glm::vec3>& edges, unsigned size, ThreadPool& pool)
+{
+	const int length = static_cast<int>(size);
+	const std::size_t voxelCount = static_cast<std::size_t>(size) * size * size;
+
+	std::vector<glm::vec3> voxels(edges.size());
+	for(std::size_t i = 0; i < edges.size(); ++i)
+	{
+		voxels[i] = DistanceFieldVoxel(edges[i], size);
+	}
+
+	//Seeding in index order keeps the smallest index per voxel, like imageAtomicMin in jumpFloodSeed.comp
+	std::vector<unsigned> seeds(voxelCount, NoSeed);
+	for(std::size_t i = voxels.size(); i-- > 0;)
+	{
+		const glm::ivec3 voxel(voxels[i]);
+		if(!InField(voxel.x, voxel.y, voxel.z, length))
+			continue;
+
+		seeds[VoxelIndex(voxel.x, voxel.y, voxel.z, length)] = static_cast<unsigned>(i);
+	}
+
+	std::vector<unsigned> flooded(voxelCount);
+	for(unsigned step = JumpFloodFirstStep(size); step > 0; step /= 2)
+	{
+		JumpFloodPass(voxels, seeds, flooded, length, step, pool);
+		seeds.swap(flooded);
+	}
+	JumpFloodPass(voxels, seeds, flooded, length, 1, pool);
+	seeds.swap(flooded);
+
+	std::vector<float> field(voxelCount);
+	pool.ParallelFor(voxelCount, [&](std::size_t begin, std::size_t end)
+	{
+		for(std::size_t index = begin; index < end; ++index)
+		{
+			const int x = static_cast<int>(index % size);
+			const int y = static_cast<int>(index / size % size);
+			const int z = static_cast<int>(index / size / size);
+
+			float distance = 1.0f;
+			if(seeds[index] != NoSeed)
+			{
+				distance = Distance(voxels[seeds[index]], x, y, z) / size;
+			}
+			field[index] = distance <= DistanceFieldMaxRadius ? distance : 1.0f;
+		}
+	});
+
+	return field;
+}
+
+std::vector<float> SplatDistanceField(const std::vector<glm::vec3>& edges, unsigned size)
+{
+	const int length = static_cast<int>(size);
+	const int box = static_cast<int>(std::ceil(DistanceFieldMaxRadius * size)) + 1;
+
+	std::vector<float> field(static_cast<std::size_t>(size) * size * size, 1.0f);
+	for(const glm::vec3& edge : edges)
+	{
+		const glm::vec3 voxel = DistanceFieldVoxel(edge, size);
+		const glm::ivec3 center(voxel);
+
+		for(int z = std::max(center.z - box, 0); z <= std::min(center.z + box, length - 1); ++z)
+		{
+			for(int y = std::max(center.y - box, 0); y <= std::min(center.y + box, length - 1); ++y)
+			{
+				for(int x = std::max(center.x - box, 0); x <= std::min(center.x + box, length - 1); ++x)
+				{
+					const float distance = Distance(voxel, x, y, z) / size;
+					float& stored = field[VoxelIndex(x, y, z, length)];
+					if(distance <= DistanceFieldMaxRadius && distance < stored)
+					{
+						stored = distance;
+					}
+				}
+			}
+		}
+	}
+
+	return field;
+}
+
+std::vector<std::vector<float>> MinReduceDistanceField(const std::vector<float>& field, unsigned size)
+{
+	const unsigned levelCount = DistanceFieldLevels(size);
+
+	std::vector<std::vector<float>> levels;
+	levels.reserve(levelCount);
+	levels.push_back(field);
+
+	for(unsigned level = 1; level < levelCount; ++level)
+	{
+		const std::vector<float>& source = levels.back();
+		const int sourceSize = static_cast<int>(size >> (level - 1));
+		const int targetSize = sourceSize / 2;
+
+		std::vector<float> target(static_cast<std::size_t>(targetSize) * targetSize * targetSize);
+		for(int z = 0; z < targetSize; ++z)
+		{
+			for(int y = 0; y < targetSize; ++y)
+			{
+				for(int x = 0; x < targetSize; ++x)
+				{
+					float minDistance = source[VoxelIndex(2 * x, 2 * y, 2 * z, sourceSize)];
+					for(int child = 1; child < 8; ++child)
+					{
+						const float distance = source[VoxelIndex(2 * x + (child & 1), 2 * y + (child >> 1 & 1), 2 * z + (child >> 2), sourceSize)];
+						minDistance = std::min(minDistance, distance);
+					}
+					target[VoxelIndex(x, y, z, targetSize)] = minDistance;
+				}
+			}
+		}
+
+		levels.push_back(std::move(target));
+	}
+
+	return levels;
+}
+
+} // namespace SPH
@@ -0,0 +1,96 @@
+/**
+ * @file DistanceField.hpp
+ * @brief 由边缘粒子生成距离场的跳跃泛洪（Jump Flooding）算法，CPU 实现与 shaders/Render 中的三个计算着色器一致。
+ */
+
+#ifndef DISTANCE_FIELD_HPP
+#define DISTANCE_FIELD_HPP
+
+#include <glm/vec3.hpp>
+
+#include <cmath>
+#include <vector>
+
+class ThreadPool;
+
+namespace SPH
+{
+
+// 只记录到最近边缘粒子的距离（以纹理边长为单位）不超过该值的体素，其余体素为 1
+constexpr float DistanceFieldMaxRadius = 0.08f;
+
+// 种子纹理中没有种子的体素
+constexpr unsigned NoSeed = 0xFFFFFFFF;
+
+/**
+ * @brief 粒子位置对应的体素坐标（未取整），立方体 [-1, 1] 映射到纹理中央约 91% 的范围。
+ * @param size 距离场纹理的边长。
+ */
+inline glm::vec3 DistanceFieldVoxel(const glm::vec3& position, unsigned size)
+{
+	return ((position + 1.0f) / 2.2f + glm::vec3(0.05f)) * static_cast<float>(size);
+}
+
+/**
+ * @brief 跳跃泛洪的第一个步长。
+ *
+ * 步长 k, k/2, ..., 1 能把种子传播到 2k - 1 个体素之外，而超过 DistanceFieldMaxRadius 的距离不会写入，
+ * 因此从覆盖该半径的最小 2 的幂开始，而不是纹理边长的一半。
+ * @param size 距离场纹理的边长。
+ */
+inline unsigned JumpFloodFirstStep(unsigned size)
+{
+	const unsigned reach = static_cast<unsigned>(std::ceil(DistanceFieldMaxRadius * size));
+
+	unsigned step = 1;
+	while(step < reach)
+		step <<= 1;
+	return step;
+}
+
+/**
+ * @brief 最小值金字塔的层数（含原始分辨率的第 0 层）。
+ *
+ * 只在边长为偶数时继续减半，使每层的一个体素恰好覆盖上一层的 2x2x2 个体素。
+ * @param size 距离场纹理的边长。
+ */
+inline unsigned DistanceFieldLevels(unsigned size)
+{
+	unsigned levels = 1;
+	while(size > 1 && size % 2 == 0)
+	{
+		size /= 2;
+		++levels;
+	}
+	return levels;
+}
+
+/**
+ * @brief 用跳跃泛洪求距离场：播种、步长逐次减半的传播，再加一次步长为 1 的传播（JFA+1）修正误差。
+ *
+ * 与 jumpFloodSeed.comp、jumpFlood.comp 与 distanceField.comp 相同，但不做边界形状的裁剪。
+ * 同一体素中有多个边缘粒子时保留下标最小的一个。
+ * @param edges 边缘粒子位置。
+ * @param size 距离场纹理的边长。
+ * @return size^3 个距离，下标为 (z * size + y) * size + x。
+ */
+std::vector<float> JumpFloodDistanceField(const std::vector<glm::vec3>& edges, unsigned size, ThreadPool& pool);
+
+/**
+ * @brief 参考实现：每个边缘粒子逐一更新覆盖 DistanceFieldMaxRadius 的体素块，结果是精确的。
+ *
+ * 即原 distanceField.comp 的做法，串行执行，没有并发写入的竞争。
+ */
+std::vector<float> SplatDistanceField(const std::vector<glm::vec3>& edges, unsigned size);
+
+/**
+ * @brief 距离场的最小值金字塔，与 minReduce.comp 相同：第 l 层每个体素是第 l - 1 层 2x2x2 个体素的最小值。
+ * @param field 第 0 层，下标为 (z * size + y) * size + x。
+ * @param size 距离场纹理的边长。
+ * @return DistanceFieldLevels(size) 层，第 l 层边长为 size >> l，第 0 层即 field。
+ */
+std::vector<std::vector<float>> MinReduceDistanceField(const std::vector<float>& field, unsigned size);
+
+} // namespace SPH
+
+#endif //DISTANCE_FIELD_HPP
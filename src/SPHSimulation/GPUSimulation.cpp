@@ -0,0 +1,61 @@
+#include "GPUSimulation.hpp"
+
+#include "SimulationState.hpp"
+#include "SimulationConfig.hpp"
+
+namespace
+{
+
+constexpr unsigned BenchmarkIterations = 50;
+
+} //unnamed namespace
+
+GPUSimulation::GPUSimulation(const SimulationConfig& config, SimulationState& state) :
+	grid(state),
+	simulation(state),
+	integrator(state),
+	edges(state, simulation)
+{
+	simulation.SetSolverPath(config.solverPath);
+
+	if(state.UsesNeighbourLists())
+	{
+		neighbours = std::make_unique<NeighbourListProgram>(state, simulation);
+	}
+
+	if(state.UsesPredictivePressure())
+	{
+		pressureSolver = std::make_unique<PressureSolverProgram>(state, simulation, config);
+	}
+}
+
+void GPUSimulation::Step(const StepParams& params)
+{
+	if(neighbours)
+	{
+		//Particle indices in the lists refer to the sorted order, so sorting only happens on rebuild
+		if(neighbours->NeedsRebuild())
+		{
+			grid.Run();
+			neighbours->Build();
+		}
+		neighbours->Run();
+	}
+	else if(pressureSolver)
+	{
+		grid.Run();
+		pressureSolver->Run(params.dt, params.gravityDir);
+		pressureSolver->ReportIterations();
+	}
+	else
+	{
+		grid.Run();
+		simulation.Run();
+	}
+	integrator.Run(params.dt, params.gravityDir, params.integrator, params.obstacleEnabled, params.obstacleRadius);
+}
+
+void GPUSimulation::Benchmark()
+{
+	simulation.Benchmark(BenchmarkIterations);
+}
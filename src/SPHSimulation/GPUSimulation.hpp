@@ -0,0 +1,65 @@
+/**
+ * @file GPUSimulation.hpp
+ * @brief 声明基于计算着色器的 SPH 后端。
+ */
+
+#ifndef GPU_SIMULATION_HPP
+#define GPU_SIMULATION_HPP
+
+#include "SimulationBackend.hpp"
+
+#include "../Program/GridProgram.hpp"
+#include "../Program/SimulationProgram.hpp"
+#include "../Program/IntegratorProgram.hpp"
+#include "../Program/NeighbourListProgram.hpp"
+#include "../Program/PressureSolverProgram.hpp"
+#include "../Program/EdgeProgram.hpp"
+
+#include <memory>
+
+/**
+ * @brief 依次运行网格排序、密度/受力与积分三个计算程序，数据全部留在 SimulationState 的缓冲中。
+ *
+ * 启用邻居表时，排序只在邻居表需要重建时运行，其余步直接按表计算密度与受力。
+ * 使用 PCISPH 时由 PressureSolverProgram 代替 SimulationProgram 计算密度与受力。
+ */
+class GPUSimulation : public SimulationBackend
+{
+private:
+	GridProgram grid;
+	SimulationProgram simulation;
+	IntegratorProgram integrator;
+	EdgeProgram edges;
+
+	// 未启用邻居表时为空
+	std::unique_ptr<NeighbourListProgram> neighbours;
+
+	// 使用状态方程求压强时为空
+	std::unique_ptr<PressureSolverProgram> pressureSolver;
+public:
+	GPUSimulation(const SimulationConfig& config, SimulationState& state);
+
+	virtual void Step(const StepParams& params) override;
+
+	virtual float MaxSpeed() override
+	{
+		return integrator.MaxSpeed();
+	}
+
+	virtual void ExtractEdges() override
+	{
+		edges.Run();
+	}
+
+	/**
+	 * @brief 用 GPU 计时查询比较 SolverPath::Separate 与 SolverPath::Packed。
+	 */
+	virtual void Benchmark() override;
+
+	virtual Type GetType() const override
+	{
+		return Type::GPU;
+	}
+};
+
+#endif //GPU_SIMULATION_HPP
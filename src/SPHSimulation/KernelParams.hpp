@@ -0,0 +1,63 @@
+/**
+ * @file KernelParams.hpp
+ * @brief SPH 平滑核的参数块：归一化系数在编译期求出，CPU 直接使用，GPU 以 UBO 形式读取。
+ */
+
+#ifndef KERNEL_PARAMS_HPP
+#define KERNEL_PARAMS_HPP
+
+#include "SPHConstants.hpp"
+
+namespace SPH
+{
+
+/**
+ * @brief 与 new.comp / forcenew.comp 中的 std140 块 KernelParams 一一对应，只含 float 成员。
+ */
+struct alignas(16) KernelParams
+{
+	float smoothingLength;
+	float smoothingLengthSquared;
+
+	// poly6: 315 / (64 pi h^9)，spiky 与粘性: 45 / (pi h^6)
+	float poly6Coefficient;
+	float spikyCoefficient;
+	float viscosityCoefficient;
+
+	float stiffness;
+	float restDensity;
+	float mass;
+	float viscosity;
+};
+
+constexpr float IntPow(float base, unsigned exponent)
+{
+	float result = 1.0f;
+	for(unsigned i = 0; i < exponent; ++i)
+	{
+		result *= base;
+	}
+
+	return result;
+}
+
+constexpr KernelParams MakeKernelParams(float smoothingLength, float stiffness, float restDensity, float mass, float viscosity)
+{
+	return KernelParams{
+		smoothingLength,
+		smoothingLength * smoothingLength,
+		315.0f / (64.0f * Pi * IntPow(smoothingLength, 9)),
+		45.0f / (Pi * IntPow(smoothingLength, 6)),
+		45.0f / (Pi * IntPow(smoothingLength, 6)),
+		stiffness,
+		restDensity,
+		mass,
+		viscosity
+	};
+}
+
+constexpr KernelParams DefaultKernelParams = MakeKernelParams(SmoothingLength, Stiffness, RestDensity, Mass, Viscosity);
+
+} // namespace SPH
+
+#endif //KERNEL_PARAMS_HPP
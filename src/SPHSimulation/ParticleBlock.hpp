@@ -0,0 +1,51 @@
+/**
+ * @file ParticleBlock.hpp
+ * @brief 生成初始粒子块的位置，GPU 与 CPU 状态共用同一初始布局。
+ */
+
+#ifndef PARTICLE_BLOCK_HPP
+#define PARTICLE_BLOCK_HPP
+
+#include <glm/vec3.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// 粒子块在各轴上的起点，spacing 为 0 时 x 方向铺满 1、y 与 z 方向铺满 2
+constexpr float ParticleBlockOrigin[3] = { -0.4f, -1.0f, -1.0f };
+constexpr float ParticleBlockExtent[3] = { 1.0f, 2.0f, 2.0f };
+
+/**
+ * @brief 按 resX * resY * resZ 的规则网格生成粒子初始位置。
+ *
+ * 顺序为 x 最外层、z 最内层，与计算着色器中的 3D 调用索引展开方式一致。
+ * @param spacing 各轴相同的粒子间距，为 0 时按分辨率铺满 ParticleBlockExtent。
+ */
+inline std::vector<glm::vec3> MakeParticleBlock(unsigned resX, unsigned resY, unsigned resZ, float spacing)
+{
+	std::vector<glm::vec3> data;
+
+	data.reserve(resX * resY * resZ);
+
+	const float multX = spacing > 0 ? spacing : ParticleBlockExtent[0] / resX;
+	const float multY = spacing > 0 ? spacing : ParticleBlockExtent[1] / resY;
+	const float multZ = spacing > 0 ? spacing : ParticleBlockExtent[2] / resZ;
+
+	for(std::size_t x = 0; x < resX; ++x)
+	{
+		for(std::size_t y = 0; y < resY; ++y)
+		{
+			for(std::size_t z = 0; z < resZ; ++z)
+			{
+				data.emplace_back(
+					ParticleBlockOrigin[0] + x * multX,
+					ParticleBlockOrigin[1] + y * multY,
+					ParticleBlockOrigin[2] + z * multZ);
+			}
+		}
+	}
+
+	return data;
+}
+
+#endif //PARTICLE_BLOCK_HPP
@@ -0,0 +1,107 @@
+/**
+ * @file PredictiveCorrection.hpp
+ * @brief PCISPH 压强迭代共用的常量、逐粒子压强修正系数与盒壁镜像边界，CPU 与 GPU 两条路径共用。
+ */
+
+#ifndef PREDICTIVE_CORRECTION_HPP
+#define PREDICTIVE_CORRECTION_HPP
+
+#include "KernelParams.hpp"
+
+#include <glm/vec3.hpp>
+
+#include <cmath>
+
+namespace SPH
+{
+
+// 即使第一次迭代后密度误差已在容差内，也至少执行这么多次迭代
+constexpr unsigned MinPressureIterations = 1;
+
+// 松弛系数：所有粒子同时修正时会互相叠加，0.5 时误差仍在奇偶迭代间振荡，0.3 时单调下降
+constexpr float PressureRelaxation = 0.3f;
+
+/**
+ * @brief 逐粒子压强修正系数 K_i：每次迭代 pressure += K_i / dt^2 * (预测密度 - 静止密度)。
+ *
+ * 由粒子在预测位置上的实际邻域求出，K_i = rho0^2 / (m^2 * (|sum grad W|^2 + sum |grad W|^2))，
+ * 再乘以 PressureRelaxation。按满邻域原型粒子求出的全局系数对表面和壁面粒子偏差过大，迭代无法收敛。
+ * GPU 版本在 new.comp 的 PREDICT_DENSITY 变体中。
+ * @param gradientSumSquared 邻居 spiky 梯度之和的模长平方。
+ * @param gradientSquaredSum 邻居 spiky 梯度模长平方之和。
+ * @return K_i，没有邻居时为 0。
+ */
+inline float PredictiveCorrectionFactor(const KernelParams& kernel, float gradientSumSquared, float gradientSquaredSum)
+{
+	const float denominator = kernel.mass * kernel.mass * (gradientSumSquared + gradientSquaredSum);
+	if(denominator <= 0.0f)
+		return 0.0f;
+
+	return PressureRelaxation * kernel.restDensity * kernel.restDensity / denominator;
+}
+
+/**
+ * @brief 壁面镜像边界：靠近盒壁的粒子把邻居关于壁外的镜面反射，作为额外的邻居（ghost 粒子）计入密度、
+ * 修正系数与压强力，ghost 的压强与密度和原粒子相同。
+ *
+ * 没有这部分时壁面粒子的邻域缺了一块，密度永远低于静止密度，压强只能把它们压向壁面，
+ * 迭代在壁面附近无法收敛。镜面在壁外半个静止间距处，贴壁的一层粒子与其镜像相距一个间距；
+ * 只镜像真实存在的邻居，自由表面不会被当作受压。GPU 版本在 wallBoundary.glsl。
+ */
+struct WallMirror
+{
+	// 各轴镜面的坐标，只有 axisMask 中对应位为 1 的轴有效
+	glm::vec3 plane;
+	unsigned axisMask;
+};
+
+/**
+ * @brief 位于 position 的粒子的镜面：到镜面不足一个平滑半径的轴才需要镜像。
+ */
+inline WallMirror MakeWallMirror(const KernelParams& kernel, const glm::vec3& position)
+{
+	const float plane = WallPosition + 0.5f * std::cbrt(kernel.mass / kernel.restDensity);
+
+	WallMirror mirror{ glm::vec3(0, 0, 0), 0u };
+	for(int axis = 0; axis < 3; ++axis)
+	{
+		if(position[axis] + plane < kernel.smoothingLength)
+		{
+			mirror.plane[axis] = -plane;
+			mirror.axisMask |= 1u << axis;
+		}
+		else if(plane - position[axis] < kernel.smoothingLength)
+		{
+			mirror.plane[axis] = plane;
+			mirror.axisMask |= 1u << axis;
+		}
+	}
+
+	return mirror;
+}
+
+/**
+ * @brief 对邻居 position 的每个镜像调用 visitor(镜像位置)。
+ * axisMask 的每个非空子集对应一个镜像，棱与角处包括两次、三次反射的镜像。
+ */
+template<typename Visitor>
+inline void ForEachMirrorImage(const WallMirror& mirror, const glm::vec3& position, Visitor&& visitor)
+{
+	for(unsigned subset = mirror.axisMask; subset != 0; subset = (subset - 1) & mirror.axisMask)
+	{
+		glm::vec3 image = position;
+		for(int axis = 0; axis < 3; ++axis)
+		{
+			if(subset & (1u << axis))
+			{
+				image[axis] = 2.0f * mirror.plane[axis] - position[axis];
+			}
+		}
+
+		visitor(image);
+	}
+}
+
+} // namespace SPH
+
+#endif //PREDICTIVE_CORRECTION_HPP
@@ -0,0 +1,35 @@
+/**
+ * @file SPHConstants.hpp
+ * @brief SPH 求解器使用的物理常量，CPU 与 GPU 两条路径共用。
+ */
+
+#ifndef SPH_CONSTANTS_HPP
+#define SPH_CONSTANTS_HPP
+
+namespace SPH
+{
+
+// 平滑核相关的值经由 KernelParams 传给着色器，其余须与 basic.comp 中的常量保持一致
+constexpr float Pi = 3.141592653589793f;
+
+constexpr float Mass = 0.005f;
+constexpr float SmoothingLength = 0.1f;
+constexpr float Stiffness = 100.0f;
+constexpr float RestDensity = 250.0f;
+constexpr float Viscosity = 5.0f;
+
+constexpr float MinDensity = 0.00001f;
+constexpr float MinDistance = 0.00001f;
+
+constexpr float EdgeThreshold = 0.0001f;
+constexpr float EdgeMinNeighbours = 30.0f;
+
+constexpr float Gravity = 9.8f;
+constexpr float Damping = 0.7f;
+
+// 盒壁位于各轴的 ±WallPosition，与 Reflect、basic.comp 一致
+constexpr float WallPosition = 1.0f;
+
+} // namespace SPH
+
+#endif //SPH_CONSTANTS_HPP
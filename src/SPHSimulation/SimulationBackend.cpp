@@ -0,0 +1,18 @@
+#include "SimulationBackend.hpp"
+
+#include "SimulationConfig.hpp"
+#include "SimulationState.hpp"
+#include "GPUSimulation.hpp"
+#include "CPUSimulation.hpp"
+
+std::unique_ptr<SimulationBackend> CreateSimulationBackend(const SimulationConfig& config, SimulationState& state)
+{
+	switch(config.backend)
+	{
+		case SimulationBackend::Type::CPU:
+			return std::make_unique<CPUSimulation>(config);
+		case SimulationBackend::Type::GPU:
+		default:
+			return std::make_unique<GPUSimulation>(config, state);
+	}
+}
@@ -0,0 +1,96 @@
+/**
+ * @file SimulationBackend.hpp
+ * @brief 声明 SPH 模拟后端的统一接口，场景可据此选择 GPU 或 CPU 实现。
+ */
+
+#ifndef SIMULATION_BACKEND_HPP
+#define SIMULATION_BACKEND_HPP
+
+#include <glm/vec3.hpp>
+
+#include <memory>
+
+class SimulationState;
+class CPUSimulationState;
+struct SimulationConfig;
+
+/**
+ * @brief 积分方式，可在运行时逐步切换。
+ */
+enum class Integrator
+{
+	// 半隐式欧拉：v += a * dt，x += v * dt
+	SymplecticEuler,
+	// 蛙跳（kick-drift-kick）：速度缓冲保存半步速度，相邻两步的半步冲量合并为
+	// v += a * (上一步 dt + 本步 dt) / 2，步长变化时仍保持二阶精度与时间可逆
+	Leapfrog,
+};
+
+/**
+ * @brief 单步模拟所需的外部参数。
+ */
+struct StepParams
+{
+	float dt;
+	glm::vec3 gravityDir;
+	Integrator integrator;
+
+	bool obstacleEnabled;
+	float obstacleRadius;
+};
+
+/**
+ * @brief 一次完整 SPH 步（网格排序、密度/压强、受力、积分）的抽象。
+ */
+class SimulationBackend
+{
+public:
+	enum class Type
+	{
+		GPU,
+		CPU,
+	};
+
+	virtual ~SimulationBackend() = default;
+
+	/**
+	 * @brief 推进一个模拟步。
+	 * @param params 本步的时间步长与外部条件。
+	 */
+	virtual void Step(const StepParams& params) = 0;
+
+	/**
+	 * @brief 若模拟数据位于主存则返回其状态，GPU 后端返回 nullptr。
+	 */
+	virtual const CPUSimulationState* HostState() const
+	{
+		return nullptr;
+	}
+
+	/**
+	 * @brief 最近已知的粒子最大速率，供 CFL 自适应步长使用。
+	 *
+	 * GPU 后端的值经异步回读得到，落后若干步；CPU 后端为上一步积分后的精确值。
+	 */
+	virtual float MaxSpeed() = 0;
+
+	/**
+	 * @brief 从最近一步的结果中提取表面粒子，模拟步本身不检测边缘，只在渲染需要时调用。
+	 *
+	 * GPU 后端直接写入 SimulationState 的边缘缓冲，CPU 后端写入 CPUSimulationState，由 SimulationState::UploadEdges 上传。
+	 */
+	virtual void ExtractEdges() = 0;
+
+	/**
+	 * @brief 比较后端内可选的求解路径并把耗时写入日志，没有可比较路径的后端不做任何事。
+	 */
+	virtual void Benchmark()
+	{
+	}
+
+	virtual Type GetType() const = 0;
+};
+
+std::unique_ptr<SimulationBackend> CreateSimulationBackend(const SimulationConfig& config, SimulationState& state);
+
+#endif //SIMULATION_BACKEND_HPP
@@ -0,0 +1,320 @@
+#include "SimulationConfig.hpp"
+
+#include "SPHConstants.hpp"
+#include "ParticleBlock.hpp"
+
+#include "../Log/Logger.h"
+
+#include <cstdlib>
+#include <string>
+
+namespace
+{
+
+// Particles are dispatched in 4x4x4 workgroups
+constexpr unsigned ParticleGroupSize = 4;
+
+} //unnamed namespace
+
+bool SimulationConfig::ParseArgument(int& index, int argc, char* args[])
+{
+	const std::string arg(args[index]);
+	const int remaining = argc - index - 1;
+
+	if(arg == "-res" && remaining >= 3)
+	{
+		resX = std::strtoul(args[++index], nullptr, 10);
+		resY = std::strtoul(args[++index], nullptr, 10);
+		resZ = std::strtoul(args[++index], nullptr, 10);
+		return true;
+	}
+	if(arg == "-spacing" && remaining >= 1)
+	{
+		particleSpacing = std::strtof(args[++index], nullptr);
+		return true;
+	}
+	if(arg == "-grid" && remaining >= 1)
+	{
+		gridResolution = std::strtoul(args[++index], nullptr, 10);
+		return true;
+	}
+	if(arg == "-threads" && remaining >= 1)
+	{
+		threads = std::strtoul(args[++index], nullptr, 10);
+		return true;
+	}
+	if(arg == "-layout" && remaining >= 1)
+	{
+		const std::string value(args[index + 1]);
+		if(value == "padded")
+			layout = ParticleLayout::Padded;
+		else if(value == "soa")
+			layout = ParticleLayout::SoA;
+		else
+			return false;
+
+		++index;
+		return true;
+	}
+	if(arg == "-cells" && remaining >= 1)
+	{
+		const std::string value(args[index + 1]);
+		if(value == "linear")
+			cellOrder = SPH::CellOrder::Linear;
+		else if(value == "morton")
+			cellOrder = SPH::CellOrder::Morton;
+		else if(value == "hashed")
+			cellOrder = SPH::CellOrder::Hashed;
+		else
+			return false;
+
+		++index;
+		return true;
+	}
+	if(arg == "-hashslots" && remaining >= 1)
+	{
+		hashSlots = std::strtoul(args[++index], nullptr, 10);
+		return true;
+	}
+	if(arg == "-solver" && remaining >= 1)
+	{
+		const std::string value(args[index + 1]);
+		if(value == "separate")
+			solverPath = SolverPath::Separate;
+		else if(value == "packed")
+			solverPath = SolverPath::Packed;
+		else
+			return false;
+
+		++index;
+		return true;
+	}
+	if(arg == "-pressure" && remaining >= 1)
+	{
+		const std::string value(args[index + 1]);
+		if(value == "eos")
+			pressureSolver = PressureSolver::EquationOfState;
+		else if(value == "pcisph")
+			pressureSolver = PressureSolver::Predictive;
+		else
+			return false;
+
+		++index;
+		return true;
+	}
+	if(arg == "-integrator" && remaining >= 1)
+	{
+		const std::string value(args[index + 1]);
+		if(value == "euler")
+			integrator = Integrator::SymplecticEuler;
+		else if(value == "leapfrog")
+			integrator = Integrator::Leapfrog;
+		else
+			return false;
+
+		++index;
+		return true;
+	}
+	if(arg == "-iterations" && remaining >= 1)
+	{
+		pressureIterations = std::strtoul(args[++index], nullptr, 10);
+		return true;
+	}
+	if(arg == "-tolerance" && remaining >= 1)
+	{
+		densityTolerance = std::strtof(args[++index], nullptr);
+		return true;
+	}
+	if(arg == "-skin" && remaining >= 1)
+	{
+		neighbourSkin = std::strtof(args[++index], nullptr);
+		return true;
+	}
+	if(arg == "-neighbours" && remaining >= 1)
+	{
+		neighbourCapacity = std::strtoul(args[++index], nullptr, 10);
+		return true;
+	}
+	if(arg == "-catchup" && remaining >= 1)
+	{
+		maxSubsteps = std::strtoul(args[++index], nullptr, 10);
+		return true;
+	}
+	if(arg == "-renderscale" && remaining >= 1)
+	{
+		const std::string value(args[index + 1]);
+		renderScale = value == "auto" ? 0 : std::strtoul(value.c_str(), nullptr, 10);
+
+		++index;
+		return true;
+	}
+	if(arg == "-checkerboard")
+	{
+		checkerboard = true;
+		return true;
+	}
+	if(arg == "-cfl" && remaining >= 1)
+	{
+		courantNumber = std::strtof(args[++index], nullptr);
+		return true;
+	}
+	if(arg == "-dtrange" && remaining >= 2)
+	{
+		minTimestep = std::strtof(args[++index], nullptr);
+		maxTimestep = std::strtof(args[++index], nullptr);
+		return true;
+	}
+	if(arg == "-cpu")
+	{
+		backend = SimulationBackend::Type::CPU;
+		return true;
+	}
+
+	return false;
+}
+
+bool SimulationConfig::Validate() const
+{
+	if(resX == 0 || resY == 0 || resZ == 0 ||
+		resX % ParticleGroupSize != 0 || resY % ParticleGroupSize != 0 || resZ % ParticleGroupSize != 0)
+	{
+		Logger::Error() << "Particle resolution must be a positive multiple of " << ParticleGroupSize << " on every axis\n";
+		return false;
+	}
+
+	if(particleSpacing < 0.0f)
+	{
+		Logger::Error() << "Particle spacing must not be negative\n";
+		return false;
+	}
+
+	const unsigned resolution[3] = { resX, resY, resZ };
+	for(int axis = 0; axis < 3; ++axis)
+	{
+		if(ParticleBlockOrigin[axis] + (resolution[axis] - 1) * particleSpacing > SPH::WallPosition)
+		{
+			Logger::Error() << "The particle block doesn't fit into the box at spacing " << particleSpacing << '\n';
+			return false;
+		}
+	}
+
+	if(gridResolution < 3)
+	{
+		Logger::Error() << "Grid resolution must be at least 3\n";
+		return false;
+	}
+
+	if(cellOrder == SPH::CellOrder::Morton && gridResolution > SPH::MaxMortonResolution)
+	{
+		Logger::Error() << "Morton cell order supports at most " << SPH::MaxMortonResolution << " cells per axis\n";
+		return false;
+	}
+
+	if(cellOrder == SPH::CellOrder::Hashed)
+	{
+		const unsigned slots = HashSlotCount();
+
+		//Every particle may claim its own cell, so a table this size can never fill up
+		if(slots < ParticleCount() || (slots & (slots - 1)) != 0)
+		{
+			Logger::Error() << "Hash slots must be a power of two no smaller than the particle count\n";
+			return false;
+		}
+	}
+
+	//Neighbour search only looks at the 27 surrounding cells
+	if(2.0f / gridResolution < SPH::SmoothingLength)
+	{
+		Logger::Error() << "Grid cells must not be smaller than the smoothing length (" << SPH::SmoothingLength << ")\n";
+		return false;
+	}
+
+	if(neighbourSkin < 0.0f)
+	{
+		Logger::Error() << "Neighbour skin must not be negative\n";
+		return false;
+	}
+
+	if(UsesNeighbourLists())
+	{
+		if(neighbourCapacity == 0)
+		{
+			Logger::Error() << "Neighbour capacity must be positive\n";
+			return false;
+		}
+
+		//Lists are built from the same 27 cells, so they must cover the skin too
+		if(2.0f / gridResolution < SPH::SmoothingLength + neighbourSkin)
+		{
+			Logger::Error() << "Grid cells must not be smaller than the smoothing length plus the neighbour skin\n";
+			return false;
+		}
+	}
+
+	if(pressureSolver == PressureSolver::Predictive)
+	{
+		if(pressureIterations == 0 || densityTolerance <= 0.0f)
+		{
+			Logger::Error() << "The predictive pressure solver needs at least one iteration and a positive tolerance\n";
+			return false;
+		}
+
+		//The iterations reuse the cell-tiled density and force kernels
+		if(UsesNeighbourLists())
+		{
+			Logger::Error() << "The predictive pressure solver can't be combined with neighbour lists\n";
+			return false;
+		}
+	}
+
+	if(maxSubsteps == 0)
+	{
+		Logger::Error() << "At least one substep per frame is required\n";
+		return false;
+	}
+
+	if(renderScale != 0 && renderScale != 1 && renderScale != 2 && renderScale != 4)
+	{
+		Logger::Error() << "Render scale must be 1, 2, 4 or auto\n";
+		return false;
+	}
+
+	if(courantNumber < 0.0f)
+	{
+		Logger::Error() << "CFL number must not be negative\n";
+		return false;
+	}
+
+	if(UsesAdaptiveTimestep() && (minTimestep <= 0.0f || minTimestep > maxTimestep))
+	{
+		Logger::Error() << "Timestep range must satisfy 0 < min <= max\n";
+		return false;
+	}
+
+	return true;
+}
+
+const char* SimulationConfig::Usage()
+{
+	return
+		"  -res <x> <y> <z>    particle block resolution, multiples of 4 (default 32 64 64)\n"
+		"  -spacing <distance> initial particle spacing, 0 = fill a 1 x 2 x 2 block (default 0)\n"
+		"  -grid <cells>       grid cells per axis (default 20)\n"
+		"  -threads <count>    CPU backend threads, 0 = hardware concurrency (default 0)\n"
+		"  -layout <mode>      GPU particle vector layout, soa or padded (default soa)\n"
+		"  -cells <order>      cell numbering, linear, morton or hashed (default linear)\n"
+		"  -hashslots <count>  hashed grid table size, a power of two (default 2 * particles rounded up)\n"
+		"  -solver <path>      GPU force pass input, separate or packed (default separate)\n"
+		"  -pressure <solver>  pressure from density, eos or pcisph (default eos)\n"
+		"  -iterations <count> most pcisph iterations per step (default 8)\n"
+		"  -tolerance <ratio>  pcisph density error relative to rest density (default 0.01)\n"
+		"  -integrator <name>  time integration, euler or leapfrog (default euler)\n"
+		"  -skin <distance>    reuse neighbour lists until a particle moves half this far (default 0, off)\n"
+		"  -neighbours <count> neighbour list capacity per particle (default 256)\n"
+		"  -catchup <steps>    most simulation steps run in one frame to catch up (default 4)\n"
+		"  -renderscale <n>    surface raycast at 1/n resolution, 1, 2, 4 or auto (default 1)\n"
+		"  -checkerboard       march half the surface pixels per frame, reproject the rest\n"
+		"  -cfl <number>       pick each step's dt from the max particle speed, 0 = fixed dt (default 0)\n"
+		"  -dtrange <min> <max> adaptive dt bounds in seconds (default 1/960 1/60)\n"
+		"  -cpu                run the solver on the CPU backend\n";
+}
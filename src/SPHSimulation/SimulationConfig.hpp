@@ -0,0 +1,141 @@
+/**
+ * @file SimulationConfig.hpp
+ * @brief 声明模拟的运行时参数（粒子数量、网格分辨率、后端等）及其命令行解析。
+ */
+
+#ifndef SIMULATION_CONFIG_HPP
+#define SIMULATION_CONFIG_HPP
+
+#include "SimulationBackend.hpp"
+#include "CellIndex.hpp"
+
+/**
+ * @brief GPU 缓冲中粒子 vec3 属性（位置、速度、受力）的存储方式。
+ */
+enum class ParticleLayout
+{
+	// std430 vec3 数组，每个元素补齐到 16 字节
+	Padded,
+	// x、y、z 各自连续存放的 float 数组，无填充
+	SoA,
+};
+
+/**
+ * @brief GPU 密度/受力阶段读取邻域数据的方式。
+ */
+enum class SolverPath
+{
+	// 受力阶段分别读取位置、速度、压强与密度数组
+	Separate,
+	// 密度阶段额外写出每个粒子 32 字节的打包记录，受力阶段每个邻居只读这一条记录
+	Packed,
+};
+
+/**
+ * @brief 由密度求压强的方式。
+ */
+enum class PressureSolver
+{
+	// 状态方程 Stiffness * (density - RestDensity)，一次求出
+	EquationOfState,
+	// PCISPH：预测位置与密度，迭代修正压强直到密度误差低于容差
+	Predictive,
+};
+
+/**
+ * @brief 模拟的运行时配置，窗口程序与 sph_headless 共用。
+ *
+ * 着色器中依赖这些值的常量由 SimulationState::DefineConstants 在编译时注入。
+ */
+struct SimulationConfig
+{
+	unsigned resX = 32;
+	unsigned resY = 64;
+	unsigned resZ = 64;
+	unsigned gridResolution = 20;
+	// 初始粒子块各轴的粒子间距，为 0 时按分辨率铺满 1 * 2 * 2 的区域
+	float particleSpacing = 0.0f;
+
+	SimulationBackend::Type backend = SimulationBackend::Type::GPU;
+	ParticleLayout layout = ParticleLayout::SoA;
+	SPH::CellOrder cellOrder = SPH::CellOrder::Linear;
+	// CellOrder::Hashed 的哈希表槽位数，为 0 时取不小于粒子数两倍的 2 的幂
+	unsigned hashSlots = 0;
+	SolverPath solverPath = SolverPath::Separate;
+	PressureSolver pressureSolver = PressureSolver::EquationOfState;
+	Integrator integrator = Integrator::SymplecticEuler;
+	unsigned threads = 0;
+
+	// 邻居表在平滑半径外额外包含的距离，为 0 时不使用邻居表，每步都重新排序并扫描 27 个单元
+	float neighbourSkin = 0.0f;
+	// 每个粒子最多记录的邻居数（含自身），超出部分被丢弃
+	unsigned neighbourCapacity = 256;
+
+	// 窗口程序每帧最多执行的模拟步数，慢帧后的积压超过该预算时被丢弃
+	unsigned maxSubsteps = 4;
+
+	// 窗口程序表面光线投射分辨率的除数（1、2 或 4），为 0 时按窗口大小自动选取
+	unsigned renderScale = 1;
+	// 相机或距离场变化的帧只投射一半像素（棋盘格），其余由上一帧重投影
+	bool checkerboard = false;
+
+	// PressureSolver::Predictive 每步最多的迭代次数，以及相对静止密度的最大密度误差
+	unsigned pressureIterations = 8;
+	float densityTolerance = 0.01f;
+
+	// CFL 数，为 0 时使用固定步长，否则每帧按粒子最大速率在 [minTimestep, maxTimestep] 内选取步长
+	float courantNumber = 0.0f;
+	float minTimestep = 0.016666666666f / 16;
+	float maxTimestep = 0.016666666666f;
+
+	inline bool UsesAdaptiveTimestep() const
+	{
+		return courantNumber > 0.0f;
+	}
+
+	inline bool UsesNeighbourLists() const
+	{
+		return neighbourSkin > 0.0f;
+	}
+
+	/**
+	 * @brief 尝试解析 args[index] 处的模拟参数，成功时把 index 移到最后一个被消费的参数。
+	 * @return 参数被识别并完整解析时返回 true。
+	 */
+	bool ParseArgument(int& index, int argc, char* args[]);
+
+	/**
+	 * @brief 检查配置是否可用，不可用时输出错误日志。
+	 */
+	bool Validate() const;
+
+	inline unsigned ParticleCount() const
+	{
+		return resX * resY * resZ;
+	}
+
+	/**
+	 * @brief 实际使用的哈希表槽位数。
+	 *
+	 * 默认值保证即使每个粒子各占一个单元，装载率也不超过一半。
+	 */
+	inline unsigned HashSlotCount() const
+	{
+		if(hashSlots > 0)
+			return hashSlots;
+
+		unsigned slots = 1;
+		while(slots < 2 * ParticleCount())
+			slots <<= 1;
+		return slots;
+	}
+
+	inline unsigned CellSlotCount() const
+	{
+		return SPH::CellSlotCount(cellOrder, gridResolution, HashSlotCount());
+	}
+
+	static const char* Usage();
+};
+
+#endif //SIMULATION_CONFIG_HPP
@@ -1,14 +1,33 @@
 #include "SimulationState.hpp"
 
+#include "CPUSimulationState.hpp"
+#include "ParticleBlock.hpp"
+#include "SimulationConfig.hpp"
+
 #include <glm/vec3.hpp>
 #include <cmath>
 
-SimulationState::SimulationState(unsigned _resX, unsigned _resY, unsigned _resZ, GLuint _gridResolution) :
-	resX(_resX),
-	resY(_resY),
-	resZ(_resZ),
-	gridResolution(_gridResolution),
-	firstIsForward(true)
+namespace
+{
+
+constexpr const char* CellIndexSource = "../shaders/Grid/cellIndex.glsl";
+
+} //unnamed namespace
+
+SimulationState::SimulationState(const SimulationConfig& config) :
+	resX(config.resX),
+	resY(config.resY),
+	resZ(config.resZ),
+	gridResolution(config.gridResolution),
+	layout(config.layout),
+	cellOrder(config.cellOrder),
+	cellSlots(config.CellSlotCount()),
+	neighbourSkin(config.neighbourSkin),
+	neighbourCapacity(config.neighbourCapacity),
+	particleSpacing(config.particleSpacing),
+	predictivePressure(config.pressureSolver == PressureSolver::Predictive),
+	firstIsForward(true),
+	overflowReadback(sizeof(GLuint))
 {
 	InitBuffers();
 
@@ -18,8 +37,13 @@ SimulationState::SimulationState(unsigned _resX, unsigned _resY, unsigned _resZ,
 	velocityStorage1.AttachBuffer(velocityBuffer1);
 	velocityStorage2.AttachBuffer(velocityBuffer2);
 
-	superBlockStorage.AttachBuffer(superBlockBuffer);
 	gridStorage.AttachBuffer(gridBuffer);
+	activeCellStorage.AttachBuffer(activeCellBuffer);
+	cellDispatchStorage.AttachBuffer(cellDispatchBuffer);
+	if(cellOrder == SPH::CellOrder::Hashed)
+	{
+		cellKeyStorage.AttachBuffer(cellKeyBuffer);
+	}
 	particleIndexStorage.AttachBuffer(particleIndexBuffer);
 
 	pressureStorage.AttachBuffer(pressureBuffer);
@@ -28,6 +52,27 @@ SimulationState::SimulationState(unsigned _resX, unsigned _resY, unsigned _resZ,
 	forceStorage.AttachBuffer(forceBuffer);
 
 	edgeStorage.AttachBuffer(edgeBuffer);
+	edgeDispatchStorage.AttachBuffer(edgeDispatchBuffer);
+	overflowStorage.AttachBuffer(overflowBuffer);
+	maxSpeedStorage.AttachBuffer(maxSpeedBuffer);
+	packedParticleStorage.AttachBuffer(packedParticleBuffer);
+
+	if(UsesNeighbourLists())
+	{
+		referencePositionStorage.AttachBuffer(referencePositionBuffer);
+		neighbourCountStorage.AttachBuffer(neighbourCountBuffer);
+		neighbourListStorage.AttachBuffer(neighbourListBuffer);
+		neighbourStateStorage.AttachBuffer(neighbourStateBuffer);
+	}
+
+	if(UsesPredictivePressure())
+	{
+		viscosityForceStorage.AttachBuffer(viscosityForceBuffer);
+		predictedPositionStorage.AttachBuffer(predictedPositionBuffer);
+		pressureSolverStateStorage.AttachBuffer(pressureSolverStateBuffer);
+		pressureSolverDispatchStorage.AttachBuffer(pressureSolverDispatchBuffer);
+		previousPressureStorage.AttachBuffer(previousPressureBuffer);
+	}
 }
 
 struct alignas(16) SimulationState::alignedVector
@@ -44,52 +89,112 @@ struct alignas(16) SimulationState::alignedVector
 	}
 };
 
-
-std::vector<SimulationState::alignedVector> SimulationState::MakeGrid()
+std::vector<SimulationState::alignedVector> SimulationState::Pad(const std::vector<glm::vec3>& data)
 {
-	std::vector<alignedVector> data;
-
-	data.reserve(resX * resY * resZ);
+	return std::vector<alignedVector>(data.begin(), data.end());
+}
 
-	const float multX = 1. / resX;
-	const float multY = 2. / resY;
-	const float multZ = 2. / resZ;
+std::vector<GLfloat> SimulationState::PackParticleVectors(const std::vector<glm::vec3>& data) const
+{
+	const std::size_t count = data.size();
 
-	for(size_t x = 0; x < resX; ++x)
+	if(layout == ParticleLayout::SoA)
 	{
-		for(size_t y = 0; y < resY; ++y)
+		//x block, then y block, then z block, each ParticleCount() long
+		std::vector<GLfloat> packed(3 * count);
+		for(std::size_t i = 0; i < count; ++i)
 		{
-			for(size_t z = 0; z < resZ; ++z)
-			{
-				data.emplace_back(x * multX - 0.4, y * multY - 1.0, z * multZ - 1.0);
-			}
+			packed[i] = data[i].x;
+			packed[count + i] = data[i].y;
+			packed[2 * count + i] = data[i].z;
 		}
+		return packed;
 	}
 
-	return data;
+	std::vector<GLfloat> packed(4 * count, 0.0f);
+	for(std::size_t i = 0; i < count; ++i)
+	{
+		packed[4 * i] = data[i].x;
+		packed[4 * i + 1] = data[i].y;
+		packed[4 * i + 2] = data[i].z;
+	}
+	return packed;
+}
+
+GLuint SimulationState::ParticleVectorBufferSize() const
+{
+	const GLuint components = layout == ParticleLayout::SoA ? 3 : 4;
+	return ParticleCount() * components * sizeof(GLfloat);
 }
 
 void SimulationState::InitBuffers()
 {
-	auto data = MakeGrid();
-	positionBuffer1.BufferData(data, GL_DYNAMIC_COPY);
-	positionBuffer2.InitEmpty(data.size() * sizeof(data[0]), GL_DYNAMIC_COPY);
+	const unsigned count = ParticleCount();
+	const GLuint vectorBufferSize = ParticleVectorBufferSize();
+
+	positionBuffer1.BufferData(PackParticleVectors(MakeParticleBlock(resX, resY, resZ, particleSpacing)), GL_DYNAMIC_COPY);
+	positionBuffer2.InitEmpty(vectorBufferSize, GL_DYNAMIC_COPY);
 
-	velocityBuffer1.InitEmpty(data.size() * sizeof(data[0]), GL_DYNAMIC_COPY);
-	glClearNamedBufferData(	velocityBuffer1.GetId(), GL_RGBA32F, GL_RED, GL_FLOAT, nullptr);
+	velocityBuffer1.InitEmpty(vectorBufferSize, GL_DYNAMIC_COPY);
+	glClearNamedBufferData(	velocityBuffer1.GetId(), GL_R32F, GL_RED, GL_FLOAT, nullptr);
 
-	velocityBuffer2.InitEmpty(data.size() * sizeof(data[0]), GL_DYNAMIC_COPY);
+	velocityBuffer2.InitEmpty(vectorBufferSize, GL_DYNAMIC_COPY);
 
-	forceBuffer.InitEmpty(data.size() * sizeof(data[0]), GL_DYNAMIC_COPY);
+	forceBuffer.InitEmpty(vectorBufferSize, GL_DYNAMIC_COPY);
+
+	particleIndexBuffer.InitEmpty(2 * count * sizeof(GLuint), GL_DYNAMIC_COPY);
+	gridBuffer.InitEmpty(CellSlotCount() * sizeof(GLuint), GL_DYNAMIC_COPY);
+	activeCellBuffer.InitEmpty(CellSlotCount() * sizeof(GLuint), GL_DYNAMIC_COPY);
+	cellDispatchBuffer.InitEmpty(3 * sizeof(GLuint), GL_DYNAMIC_COPY);
+
+	if(cellOrder == SPH::CellOrder::Hashed)
+	{
+		cellKeyBuffer.InitEmpty(CellSlotCount() * sizeof(GLuint), GL_DYNAMIC_COPY);
+		ResetCellKeys();
+	}
 
-	particleIndexBuffer.InitEmpty(2 * data.size() * sizeof(GLuint), GL_DYNAMIC_COPY);
-	gridBuffer.InitEmpty(gridResolution * gridResolution * gridResolution * sizeof(GLuint), GL_DYNAMIC_COPY);
-	superBlockBuffer.InitEmpty(gridResolution * gridResolution * gridResolution * sizeof(GLuint) / 200, GL_DYNAMIC_COPY);
+	pressureBuffer.InitEmpty(count * sizeof(GLfloat), GL_DYNAMIC_COPY);
+	densityBufffer.InitEmpty(count * sizeof(GLfloat), GL_DYNAMIC_COPY);
 
-	pressureBuffer.InitEmpty(data.size() * sizeof(GLfloat), GL_DYNAMIC_COPY);
-	densityBufffer.InitEmpty(data.size() * sizeof(GLfloat), GL_DYNAMIC_COPY);
+	//Edge positions are always padded, the counter takes the first vec3 slot
+	edgeBuffer.InitEmpty((count + 1) * sizeof(alignedVector), GL_DYNAMIC_COPY);
 
-	edgeBuffer.InitEmpty(data.size() * sizeof(data[0]), GL_DYNAMIC_COPY);
+	//Nothing is drawn until the first extraction
+	edgeDispatchBuffer.InitEmpty(7 * sizeof(GLuint), GL_DYNAMIC_COPY);
+	SetEdgeArguments(0);
+
+	//Stays zero on the CPU backend, which has no per-cell limit
+	overflowBuffer.InitEmpty(sizeof(GLuint), GL_DYNAMIC_COPY);
+	ResetOverflowCount();
+
+	maxSpeedBuffer.InitEmpty(sizeof(GLuint), GL_DYNAMIC_COPY);
+	ResetMaxSpeed();
+
+	packedParticleBuffer.InitEmpty(count * 8 * sizeof(GLfloat), GL_DYNAMIC_COPY);
+
+	if(UsesNeighbourLists())
+	{
+		referencePositionBuffer.InitEmpty(vectorBufferSize, GL_DYNAMIC_COPY);
+		neighbourCountBuffer.InitEmpty(count * sizeof(GLuint), GL_DYNAMIC_COPY);
+		neighbourListBuffer.InitEmpty(neighbourCapacity * count * sizeof(GLuint), GL_DYNAMIC_COPY);
+		neighbourStateBuffer.InitEmpty(2 * sizeof(GLuint), GL_DYNAMIC_COPY);
+		ResetNeighbourState();
+	}
+
+	if(UsesPredictivePressure())
+	{
+		viscosityForceBuffer.InitEmpty(vectorBufferSize, GL_DYNAMIC_COPY);
+		predictedPositionBuffer.InitEmpty(vectorBufferSize, GL_DYNAMIC_COPY);
+		pressureSolverStateBuffer.InitEmpty(3 * sizeof(GLuint), GL_DYNAMIC_COPY);
+		ResetPressureSolverState();
+
+		//Three indirect dispatch commands, refilled before every step
+		pressureSolverDispatchBuffer.InitEmpty(9 * sizeof(GLuint), GL_DYNAMIC_COPY);
+
+		//The grid scatter permutes the pressure of the previous step, the first step starts from zero
+		previousPressureBuffer.InitEmpty(count * sizeof(GLfloat), GL_DYNAMIC_COPY);
+		ResetPressure();
+	}
 
 	//Note to self: forgeting syncronization screws things up so dont do it
 	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
@@ -99,3 +204,77 @@ void SimulationState::SwapBuffers()
 {
 	firstIsForward = !firstIsForward;
 }
+
+void SimulationState::DefineConstants(GL::Shader& shader) const
+{
+	shader.Define("NUM_PARTICLES", ParticleCount());
+	shader.Define("NUM_GRID_CELLS", gridResolution);
+	shader.Define("NUM_CELL_SLOTS", CellSlotCount());
+	shader.Define("NEIGHBOUR_CAPACITY", neighbourCapacity);
+
+	if(layout == ParticleLayout::SoA)
+	{
+		shader.Define("PARTICLE_LAYOUT_SOA");
+		shader.Define("PARTICLE_VEC3_ARRAY(name)", "float name[]");
+		shader.Define("LOAD_VEC3(array, index)",
+			"vec3(array[index], array[(index) + NUM_PARTICLES], array[(index) + 2u * NUM_PARTICLES])");
+		shader.Define("STORE_VEC3(array, index, value)",
+			"array[index] = (value).x, array[(index) + NUM_PARTICLES] = (value).y, array[(index) + 2u * NUM_PARTICLES] = (value).z");
+	}
+	else
+	{
+		shader.Define("PARTICLE_LAYOUT_PADDED");
+		shader.Define("PARTICLE_VEC3_ARRAY(name)", "vec3 name[]");
+		shader.Define("LOAD_VEC3(array, index)", "array[index]");
+		shader.Define("STORE_VEC3(array, index, value)", "array[index] = (value)");
+	}
+
+	if(cellOrder == SPH::CellOrder::Morton)
+	{
+		shader.Define("CELL_ORDER_MORTON");
+	}
+	else if(cellOrder == SPH::CellOrder::Hashed)
+	{
+		shader.Define("CELL_ORDER_HASHED");
+		shader.Define("HASHED_AXIS_BITS", SPH::HashedAxisBits);
+	}
+	shader.Include(CellIndexSource);
+}
+
+void SimulationState::Upload(const CPUSimulationState& host)
+{
+	GL::Buffer& positionBuffer = firstIsForward ? positionBuffer1 : positionBuffer2;
+	GL::Buffer& velocityBuffer = firstIsForward ? velocityBuffer1 : velocityBuffer2;
+
+	auto positions = PackParticleVectors(host.Positions());
+	positionBuffer.BufferSubData(0, positions.size() * sizeof(GLfloat), positions.data());
+
+	auto velocities = PackParticleVectors(host.Velocities());
+	velocityBuffer.BufferSubData(0, velocities.size() * sizeof(GLfloat), velocities.data());
+
+	auto forces = PackParticleVectors(host.Forces());
+	forceBuffer.BufferSubData(0, forces.size() * sizeof(GLfloat), forces.data());
+
+	pressureBuffer.BufferSubData(0, host.Pressures().size() * sizeof(GLfloat), host.Pressures().data());
+	densityBufffer.BufferSubData(0, host.Densities().size() * sizeof(GLfloat), host.Densities().data());
+
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+}
+
+void SimulationState::UploadEdges(const CPUSimulationState& host)
+{
+	//std430: the edge array starts at the next vec3 aligned offset after the counter
+	GLuint edgeCount = host.GetEdgeCount();
+	edgeBuffer.BufferSubData(0, sizeof(edgeCount), &edgeCount);
+
+	auto edges = Pad(host.EdgePositions());
+	if(!edges.empty())
+	{
+		edgeBuffer.BufferSubData(sizeof(alignedVector), edges.size() * sizeof(edges[0]), edges.data());
+	}
+
+	//The count is already on the CPU here, no need for edgeDispatch.comp
+	SetEdgeArguments(edgeCount);
+
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+}
@@ -4,10 +4,18 @@
 #include "../Helper/Buffer.hpp"
 #include "../Helper/ShaderStorage.hpp"
 #include "../Helper/Program.hpp"
+#include "../Helper/Shader.hpp"
+#include "../Helper/ReadbackRing.hpp"
+
+#include "CellIndex.hpp"
 
 #include <GL/glew.h>
 #include <glm/vec3.hpp>
 
+class CPUSimulationState;
+struct SimulationConfig;
+enum class ParticleLayout;
+
 class SimulationState
 {
 private:
@@ -17,21 +25,47 @@ private:
 	GL::Buffer velocityBuffer2;
 	GL::Buffer particleIndexBuffer;
 	GL::Buffer gridBuffer;
-	GL::Buffer superBlockBuffer;
+	GL::Buffer activeCellBuffer;
+	GL::Buffer cellDispatchBuffer;
+	// 仅在 CellOrder::Hashed 时分配：每个槽位所存单元的键，空槽位为 SPH::EmptyCellKey
+	GL::Buffer cellKeyBuffer;
 
 	GL::Buffer pressureBuffer;
 	GL::Buffer densityBufffer;
 	GL::Buffer forceBuffer;
 
 	GL::Buffer edgeBuffer;
+	// 由边缘粒子数得到的间接命令，见 EdgeDispatchOffset 与 EdgeDrawOffset
+	GL::Buffer edgeDispatchBuffer;
+	GL::Buffer overflowBuffer;
+	GL::Buffer maxSpeedBuffer;
+
+	// SolverPath::Packed 的每粒子记录：vec4(位置, 压强) 与 vec4(速度, 1 / 密度)
+	GL::Buffer packedParticleBuffer;
+
+	// 仅在启用邻居表时分配
+	GL::Buffer referencePositionBuffer;
+	GL::Buffer neighbourCountBuffer;
+	GL::Buffer neighbourListBuffer;
+	GL::Buffer neighbourStateBuffer;
+
+	// 仅在使用 PressureSolver::Predictive 时分配
+	GL::Buffer viscosityForceBuffer;
+	GL::Buffer predictedPositionBuffer;
+	GL::Buffer pressureSolverStateBuffer;
+	GL::Buffer pressureSolverDispatchBuffer;
+	// 上一步迭代结束时的压强，由网格排序按新顺序写入，作为下一步迭代的初值
+	GL::Buffer previousPressureBuffer;
 
 	GL::ShaderStorage positionStorage1;
 	GL::ShaderStorage positionStorage2;
 	GL::ShaderStorage velocityStorage1;
 	GL::ShaderStorage velocityStorage2;
 
-	GL::ShaderStorage superBlockStorage;
 	GL::ShaderStorage gridStorage;
+	GL::ShaderStorage activeCellStorage;
+	GL::ShaderStorage cellDispatchStorage;
+	GL::ShaderStorage cellKeyStorage;
 	GL::ShaderStorage particleIndexStorage;
 
 	GL::ShaderStorage pressureStorage;
@@ -39,6 +73,21 @@ private:
 	GL::ShaderStorage forceStorage;
 
 	GL::ShaderStorage edgeStorage;
+	GL::ShaderStorage edgeDispatchStorage;
+	GL::ShaderStorage overflowStorage;
+	GL::ShaderStorage maxSpeedStorage;
+	GL::ShaderStorage packedParticleStorage;
+
+	GL::ShaderStorage referencePositionStorage;
+	GL::ShaderStorage neighbourCountStorage;
+	GL::ShaderStorage neighbourListStorage;
+	GL::ShaderStorage neighbourStateStorage;
+
+	GL::ShaderStorage viscosityForceStorage;
+	GL::ShaderStorage predictedPositionStorage;
+	GL::ShaderStorage pressureSolverStateStorage;
+	GL::ShaderStorage pressureSolverDispatchStorage;
+	GL::ShaderStorage previousPressureStorage;
 
 	const unsigned resX;
 	const unsigned resY;
@@ -46,17 +95,59 @@ private:
 
 	const GLuint gridResolution;
 
+	const ParticleLayout layout;
+	const SPH::CellOrder cellOrder;
+	const unsigned cellSlots;
+
+	const float neighbourSkin;
+	const unsigned neighbourCapacity;
+
+	const float particleSpacing;
+	const bool predictivePressure;
+
 	bool firstIsForward;
 
+	GL::ReadbackRing overflowReadback;
+
 	struct alignas(16) alignedVector;
 
-	std::vector<alignedVector> MakeGrid();
+	static std::vector<alignedVector> Pad(const std::vector<glm::vec3>& data);
+	std::vector<GLfloat> PackParticleVectors(const std::vector<glm::vec3>& data) const;
+	GLuint ParticleVectorBufferSize() const;
 	void InitBuffers();
 public:
-	SimulationState(unsigned _resX, unsigned _resY, unsigned _resZ, GLuint _gridResolution);
+	// 边缘分派缓冲中距离场计算的 glDispatchComputeIndirect 参数
+	static constexpr GLintptr EdgeDispatchOffset = 0;
+	// 边缘分派缓冲中边缘点的 glDrawArraysIndirect 参数
+	static constexpr GLintptr EdgeDrawOffset = 3 * sizeof(GLuint);
+	// distanceField.comp 的工作组大小
+	static constexpr GLuint EdgeGroupSize = 64;
+
+	SimulationState(const SimulationConfig& config);
 
 	void SwapBuffers();
 
+	/**
+	 * @brief 将 CPU 后端的结果写入当前前向缓冲，使渲染路径与 GPU 后端一致。
+	 * @param host CPU 模拟状态，尺寸必须与本状态相同。
+	 */
+	void Upload(const CPUSimulationState& host);
+
+	/**
+	 * @brief 将 CPU 后端提取的边缘粒子写入边缘缓冲，在 SimulationBackend::ExtractEdges 之后调用。
+	 * @param host CPU 模拟状态。
+	 */
+	void UploadEdges(const CPUSimulationState& host);
+
+	/**
+	 * @brief 把粒子数、网格分辨率等与配置相关的常量作为宏注入着色器。
+	 *
+	 * 同时生成粒子 vec3 属性的访问宏，着色器只通过它们读写位置、速度与受力：
+	 * PARTICLE_VEC3_ARRAY(name) 声明数组，LOAD_VEC3(array, index) 读取，
+	 * STORE_VEC3(array, index, value) 写入（value 会被多次求值，应传入变量）。
+	 */
+	void DefineConstants(GL::Shader& shader) const;
+
 	inline void AttachPosition(const GL::Program& program, const char* name)
 	{
 		if(firstIsForward)
@@ -107,14 +198,30 @@ public:
 
 	//TODO velocity same as above
 
-	inline void AttachSuperBlock(const GL::Program& program, const char* name)
+	inline void AttachGrid(const GL::Program& program, const char* name)
+	{
+		gridStorage.AttachToBlock(program, program.GetShaderStorageBlockIndex(name));
+	}
+
+	inline void AttachActiveCells(const GL::Program& program, const char* name)
 	{
-		superBlockStorage.AttachToBlock(program, program.GetShaderStorageBlockIndex(name));
+		activeCellStorage.AttachToBlock(program, program.GetShaderStorageBlockIndex(name));
 	}
 
-	inline void AttachGrid(const GL::Program& program, const char* name)
+	inline void AttachCellDispatch(const GL::Program& program, const char* name)
 	{
-		gridStorage.AttachToBlock(program, program.GetShaderStorageBlockIndex(name));
+		cellDispatchStorage.AttachToBlock(program, program.GetShaderStorageBlockIndex(name));
+	}
+
+	/**
+	 * @brief 绑定哈希网格的键表，供 cellIndex.glsl 查找单元；其他编号方式下着色器没有该块，不做任何事。
+	 */
+	inline void AttachCellKeys(const GL::Program& program, const char* name)
+	{
+		if(cellOrder == SPH::CellOrder::Hashed)
+		{
+			cellKeyStorage.AttachToBlock(program, program.GetShaderStorageBlockIndex(name));
+		}
 	}
 
 	inline void AttachParticleIndex(const GL::Program& program, const char* name)
@@ -142,19 +249,189 @@ public:
 		edgeStorage.AttachToBlock(program, program.GetShaderStorageBlockIndex(name));
 	}
 
-	inline unsigned GetEdgeCount()
+	inline void AttachEdgeDispatch(const GL::Program& program, const char* name)
 	{
-		unsigned* edgeCount = reinterpret_cast<unsigned*>(glMapNamedBufferRange(edgeBuffer.GetId(), 0, 4, GL_MAP_READ_BIT));
-		glUnmapNamedBuffer(edgeBuffer.GetId());
+		edgeDispatchStorage.AttachToBlock(program, program.GetShaderStorageBlockIndex(name));
+	}
 
-		return *edgeCount;
+	inline void AttachOverflow(const GL::Program& program, const char* name)
+	{
+		overflowStorage.AttachToBlock(program, program.GetShaderStorageBlockIndex(name));
 	}
 
 	inline void ResetEdgeCount()
 	{
-		unsigned* edgeCount = reinterpret_cast<unsigned*>(glMapNamedBufferRange(edgeBuffer.GetId(), 0, 4, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
-		*edgeCount = 0;
-		glUnmapNamedBuffer(edgeBuffer.GetId());
+		glClearNamedBufferSubData(edgeBuffer.GetId(), GL_R32UI, 0, sizeof(GLuint), GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+	}
+
+	/**
+	 * @brief 最近一次已回读的、粒子数超过一个工作组而被分块处理的单元数。
+	 */
+	inline unsigned GetOverflowCellCount()
+	{
+		overflowReadback.Poll();
+		return overflowReadback.Latest<GLuint>();
+	}
+
+	inline void ResetOverflowCount()
+	{
+		glClearNamedBufferData(overflowBuffer.GetId(), GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+	}
+
+	inline void AttachMaxSpeed(const GL::Program& program, const char* name)
+	{
+		maxSpeedStorage.AttachToBlock(program, program.GetShaderStorageBlockIndex(name));
+	}
+
+	/**
+	 * @brief 积分阶段归约出的粒子最大速率（float 位模式），每步积分前清零。
+	 */
+	inline const GL::Buffer& MaxSpeedBuffer() const
+	{
+		return maxSpeedBuffer;
+	}
+
+	inline void ResetMaxSpeed()
+	{
+		glClearNamedBufferData(maxSpeedBuffer.GetId(), GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+	}
+
+	inline void AttachPackedParticles(const GL::Program& program, const char* name)
+	{
+		packedParticleStorage.AttachToBlock(program, program.GetShaderStorageBlockIndex(name));
+	}
+
+	inline void AttachReferencePositions(const GL::Program& program, const char* name)
+	{
+		referencePositionStorage.AttachToBlock(program, program.GetShaderStorageBlockIndex(name));
+	}
+
+	inline void AttachNeighbourCounts(const GL::Program& program, const char* name)
+	{
+		neighbourCountStorage.AttachToBlock(program, program.GetShaderStorageBlockIndex(name));
+	}
+
+	inline void AttachNeighbourLists(const GL::Program& program, const char* name)
+	{
+		neighbourListStorage.AttachToBlock(program, program.GetShaderStorageBlockIndex(name));
+	}
+
+	inline void AttachNeighbourState(const GL::Program& program, const char* name)
+	{
+		neighbourStateStorage.AttachToBlock(program, program.GetShaderStorageBlockIndex(name));
+	}
+
+	/**
+	 * @brief 邻居表的状态字：本步最大位移（float 位模式）与邻居数被截断的粒子数。
+	 */
+	inline const GL::Buffer& NeighbourStateBuffer() const
+	{
+		return neighbourStateBuffer;
+	}
+
+	inline void ResetNeighbourState()
+	{
+		glClearNamedBufferData(neighbourStateBuffer.GetId(), GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+	}
+
+	inline void ResetNeighbourDisplacement()
+	{
+		glClearNamedBufferSubData(neighbourStateBuffer.GetId(), GL_R32UI, 0, sizeof(GLuint), GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+	}
+
+	inline void AttachViscosityForce(const GL::Program& program, const char* name)
+	{
+		viscosityForceStorage.AttachToBlock(program, program.GetShaderStorageBlockIndex(name));
+	}
+
+	inline void AttachPredictedPosition(const GL::Program& program, const char* name)
+	{
+		predictedPositionStorage.AttachToBlock(program, program.GetShaderStorageBlockIndex(name));
+	}
+
+	inline void AttachPressureSolverState(const GL::Program& program, const char* name)
+	{
+		pressureSolverStateStorage.AttachToBlock(program, program.GetShaderStorageBlockIndex(name));
+	}
+
+	inline void AttachPressureSolverDispatch(const GL::Program& program, const char* name)
+	{
+		pressureSolverDispatchStorage.AttachToBlock(program, program.GetShaderStorageBlockIndex(name));
+	}
+
+	inline void AttachPreviousPressure(const GL::Program& program, const char* name)
+	{
+		previousPressureStorage.AttachToBlock(program, program.GetShaderStorageBlockIndex(name));
+	}
+
+	/**
+	 * @brief 受力阶段在零压强下求出的粘性力，PCISPH 每次迭代在其上叠加压强力写入受力缓冲。
+	 */
+	inline const GL::Buffer& ViscosityForceBuffer() const
+	{
+		return viscosityForceBuffer;
+	}
+
+	/**
+	 * @brief 把排序后的上一步压强复制到压强缓冲，作为 PCISPH 迭代的初值。
+	 */
+	inline void RestorePreviousPressure()
+	{
+		glCopyNamedBufferSubData(previousPressureBuffer.GetId(), pressureBuffer.GetId(), 0, 0, ParticleCount() * sizeof(GLfloat));
+	}
+
+	inline void ResetPressure()
+	{
+		glClearNamedBufferData(pressureBuffer.GetId(), GL_R32F, GL_RED, GL_FLOAT, nullptr);
+	}
+
+	/**
+	 * @brief PCISPH 的状态字：本次迭代的最大密度误差（float 位模式）、已执行的迭代数与上一次迭代的误差。
+	 */
+	inline const GL::Buffer& PressureSolverStateBuffer() const
+	{
+		return pressureSolverStateBuffer;
+	}
+
+	inline void ResetPressureSolverState()
+	{
+		glClearNamedBufferData(pressureSolverStateBuffer.GetId(), GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+	}
+
+	/**
+	 * @brief PCISPH 迭代的三组间接分派参数：按单元、按粒子与收敛检查，收敛后由 GPU 清零。
+	 */
+	inline GL::Buffer& PressureSolverDispatchBuffer()
+	{
+		return pressureSolverDispatchBuffer;
+	}
+
+	inline bool UsesNeighbourLists() const
+	{
+		return neighbourSkin > 0.0f;
+	}
+
+	inline bool UsesPredictivePressure() const
+	{
+		return predictivePressure;
+	}
+
+	inline float NeighbourSkin() const
+	{
+		return neighbourSkin;
+	}
+
+	inline unsigned NeighbourCapacity() const
+	{
+		return neighbourCapacity;
+	}
+
+	/**
+	 * @brief 在模拟步末尾记录溢出单元数的回读命令，结果由 GetOverflowCellCount 在完成后取得。
+	 */
+	inline void CaptureCounters()
+	{
+		overflowReadback.Capture(overflowBuffer, 0);
 	}
 
 	inline unsigned ResX() const
@@ -177,15 +454,81 @@ public:
 		return gridResolution;
 	}
 
+	inline ParticleLayout Layout() const
+	{
+		return layout;
+	}
+
+	inline unsigned ParticleCount() const
+	{
+		return resX * resY * resZ;
+	}
+
+	inline unsigned CellCount() const
+	{
+		return gridResolution * gridResolution * gridResolution;
+	}
+
+	/**
+	 * @brief 单元编号的取值范围，网格缓冲、扫描与活动单元列表都按它分配。
+	 */
+	inline unsigned CellSlotCount() const
+	{
+		return cellSlots;
+	}
+
+	/**
+	 * @brief 清空哈希网格的键表，每次建网格前调用。
+	 */
+	inline void ResetCellKeys()
+	{
+		if(cellOrder == SPH::CellOrder::Hashed)
+		{
+			const GLuint empty = SPH::EmptyCellKey;
+			glClearNamedBufferData(cellKeyBuffer.GetId(), GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &empty);
+		}
+	}
+
 	inline GL::Buffer& GridBuffer()
 	{
 		return gridBuffer;
 	}
 
+	/**
+	 * @brief 每个非空单元一个工作组的间接分派参数，由 compact.comp 填写。
+	 */
+	inline GL::Buffer& CellDispatchBuffer()
+	{
+		return cellDispatchBuffer;
+	}
+
+	inline void ResetCellDispatch()
+	{
+		const GLuint emptyDispatch[3] = {0, 1, 1};
+		cellDispatchBuffer.BufferSubData(0, sizeof(emptyDispatch), emptyDispatch);
+	}
+
 	inline GL::Buffer& EdgeBuffer()
 	{
 		return edgeBuffer;
 	}
+
+	/**
+	 * @brief 距离场分派与边缘点绘制的间接参数，GPU 后端由 edgeDispatch.comp 填写，CPU 后端由 UploadEdges 填写。
+	 */
+	inline GL::Buffer& EdgeDispatchBuffer()
+	{
+		return edgeDispatchBuffer;
+	}
+
+	/**
+	 * @brief 按已知的边缘粒子数写入间接参数，不经过 GPU。
+	 */
+	inline void SetEdgeArguments(GLuint edgeCount)
+	{
+		const GLuint arguments[7] = {(edgeCount + EdgeGroupSize - 1) / EdgeGroupSize, 1, 1, edgeCount, 1, 0, 0};
+		edgeDispatchBuffer.BufferSubData(0, sizeof(arguments), arguments);
+	}
 };
 
 #endif //SIMULATION_STATE_HPP
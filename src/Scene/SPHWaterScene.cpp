@@ -9,21 +9,11 @@
 #include "../Log/Logger.h"
 #include "../Main/Game.h"
 
-#include "../Program/GridProgram.hpp"
 #include "../Program/Render/Direction.hpp"
 
-#include <cmath>
 #include <GL/glew.h>
 #include <glm/vec4.hpp>
 
-static constexpr const char* positionBufferName = "positionBuffer";
-static constexpr const char* densityBufferName  = "densityBuffer";
-static constexpr const char* velocityBufferName = "velocityBuffer";
-static constexpr const char* forceBufferName = "forceBuffer";
-//static constexpr const char* indexBufferName = "indexBuffer";
-
-static constexpr const unsigned DtLocation = 0;
-
 namespace
 {
 
@@ -92,31 +82,8 @@ bool SPHWaterScene::Begin()
 {
 	glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, sizeof("Scene Init") / sizeof(char), "Scene Init");
 
-	glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, sizeof("Compute Shader") / sizeof(char), "Compute Shader");
-
-	GL::Shader gravityShader(GL_COMPUTE_SHADER);
-
-	if(!gravityShader.FromFile("../shaders/basic.comp"))
-	{
-		Logger::Error() << "Gravity Shader compilation failed: " << gravityShader.GetInfoLog() <<  '\n';
-		return false;
-	}
-
-	gravityProgram.AttachShader(gravityShader);
-
-	if(!gravityProgram.Link())
-	{
-		Logger::Error() << "Gravity Program linking failed: " << gravityProgram.GetInfoLog() <<  '\n';
-		return false;
-	}
-
-	glPopDebugGroup();
-
 	glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, sizeof("uniforms") / sizeof(char), "uniforms");
 
-	targetLocation = gravityProgram.GetUniformLocation("target");
-	dtLocation = gravityProgram.GetUniformLocation("dt");
-
 	glClearColor(1., 1., 1., 1.);
 	glEnable(GL_CULL_FACE);
 	glEnable(GL_DEPTH_TEST);
@@ -130,9 +97,6 @@ bool SPHWaterScene::Begin()
 
 	glPopDebugGroup();
 
-	state.AttachForce(gravityProgram, forceBufferName);
-	state.AttachDensity(gravityProgram, densityBufferName);
-
 	glEnable(GL_PROGRAM_POINT_SIZE);
 
 	glEnable (GL_BLEND);
@@ -168,47 +132,92 @@ void SPHWaterScene::Pause()
 
 }
 
-constexpr size_t groupX = 4;
-constexpr size_t groupY = 4;
-constexpr size_t groupZ = 4;
-
 /**
- * @brief 更新模拟状态和渲染用数据，并在时间累积到阈值时执行 SPH 模拟步。
+ * @brief 更新模拟状态和渲染用数据，按累积时间执行若干固定步长的 SPH 模拟步。
+ *
+ * 同一帧内的各步连续提交给后端，中间不做任何读回；计数器只在最后一步后采样一次。
+ * 启用自适应步长时，每帧执行完模拟步后按后端最近的最大速率与 CFL 条件选取下一帧的步长。
  * @param delta 本帧经过的时间（秒）。
  */
 void SPHWaterScene::Update(const double delta)
 {
-	timeRemainder += delta;
-
 	renderSurface.Update(delta);
 
-	if(!paused && timeRemainder >= stepTime)
+	if(paused)
+		return;
+
+	const unsigned steps = substeps.BeginFrame(delta);
+
+	if(substeps.FellBehind())
+	{
+		Logger::Info() << "Simulation fell behind, dropped " << substeps.DroppedTime() << "s so far\n";
+	}
+
+	const double ratio = substeps.SimulatedToRealRatio();
+	if(ratio != reportedSpeedRatio)
 	{
-		time += stepTime;
-		timeRemainder = std::fmod(timeRemainder, stepTime);
+		Logger::Debug() << "Simulated/real time ratio: " << ratio << '\n';
+		reportedSpeedRatio = ratio;
+	}
 
-		grid.Run();
-		simulation.Run();
+	if(steps == 0)
+		return;
 
-		gravityProgram.Use();
-		state.AttachPosition(gravityProgram, positionBufferName);
-		state.AttachVelocity(gravityProgram, velocityBufferName);
+	StepParams params;
+	params.dt = adaptiveTimestep ? timestep.Current() : stepTime / 2;
+	params.gravityDir = renderSurface.GetGravity();
+	params.integrator = integrator;
+	// Provide rigid obstacle toggle and radius to integrator
+	params.obstacleEnabled = rigidEnabled;
+	params.obstacleRadius = rigidRadius;
 
-		glUniform1f(DtLocation, stepTime / 2);
+	for(unsigned i = 0; i < steps; ++i)
+	{
+		backend->Step(params);
 
-		glm::vec3 grav = renderSurface.GetGravity();
-		glUniform3fv(1, 1, reinterpret_cast<const GLfloat*>(&grav[0]));
+		time += substeps.GetStepTime();
+		substeps.RecordStep(params.dt);
+	}
 
-		// Provide rigid obstacle toggle and radius to integrator
-		glUniform1i(2, rigidEnabled ? 1 : 0);
-		glUniform1f(3, rigidRadius);
+	if(adaptiveTimestep)
+	{
+		//One dt per frame, the GPU speed sample doesn't change between the steps of a frame anyway
+		substeps.SetStepTime(2 * timestep.Next(backend->MaxSpeed()));
+	}
 
-		glDispatchCompute(state.ResX() / groupX, state.ResY() / groupY, state.ResZ() / groupZ);
+	if(const CPUSimulationState* host = backend->HostState())
+	{
+		state.Upload(*host);
+	}
 
-		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	state.CaptureCounters();
 
-		distanceFieldDirty = true;
+	const unsigned overflowCells = state.GetOverflowCellCount();
+	if(overflowCells != reportedOverflowCells)
+	{
+		Logger::Info() << "Cells processed in multiple tiles: " << overflowCells << '\n';
+		reportedOverflowCells = overflowCells;
 	}
+
+	distanceFieldDirty = true;
+	edgesDirty = true;
+}
+
+/**
+ * @brief 模拟推进后首次需要表面时提取边缘粒子，CPU 后端还需把结果上传到边缘缓冲。
+ */
+void SPHWaterScene::ExtractEdges()
+{
+	if(!edgesDirty)
+		return;
+
+	backend->ExtractEdges();
+	if(const CPUSimulationState* host = backend->HostState())
+	{
+		state.UploadEdges(*host);
+	}
+
+	edgesDirty = false;
 }
 
 /**
@@ -228,6 +237,7 @@ void SPHWaterScene::Render()
 		case RenderMode::Surface:
 			if(distanceFieldDirty)
 			{
+				ExtractEdges();
 				renderSurface.UpdateParticles();
 				distanceFieldDirty = false;
 			}
@@ -268,6 +278,7 @@ void SPHWaterScene::Render()
 
 			int bType = renderSurface.IsSphere() ? 1 : 0;
 			float bRadius = renderSurface.GetBoundaryRadius();
+			ExtractEdges();
 			renderEdgePoints.Render(eye, planeOrigin, planeAxisX, planeAxisY, bType, bRadius);
 			// Rigid surface rendering removed per request
 			break;
@@ -348,10 +359,52 @@ void SPHWaterScene::OnKeyboard(SDL_KeyboardEvent& event)
 				Logger::Info() << "Boundary radius: " << renderSurface.GetBoundaryRadius() << '\n';
 			}
 			break;
+		case 't':
+			if(event.state == SDL_RELEASED)
+			{
+				renderSurface.ToggleMarchMode();
+				Logger::Info() << "Raycast: " << (renderSurface.IsSphereTracing() ? "Sphere tracing" : "Fixed step") << '\n';
+			}
+			break;
+		case 'g':
+			if(event.state == SDL_RELEASED)
+			{
+				renderSurface.ToggleStepView();
+				Logger::Info() << "Step count view: " << (renderSurface.IsShowingSteps() ? "ON" : "OFF") << '\n';
+			}
+			break;
+		case 'r':
+			if(event.state == SDL_RELEASED)
+			{
+				renderSurface.CycleRenderScale();
+				if(renderSurface.GetRenderScale() == 0)
+					Logger::Info() << "Render scale: auto\n";
+				else
+					Logger::Info() << "Render scale: 1/" << renderSurface.GetRenderScale() << '\n';
+			}
+			break;
+		case 'c':
+			if(event.state == SDL_RELEASED)
+			{
+				renderSurface.ToggleCheckerboard();
+				Logger::Info() << "Checkerboard raycast: " << (renderSurface.IsCheckerboard() ? "ON" : "OFF") << '\n';
+			}
+			break;
 		case 'k':
 			if(event.state == SDL_RELEASED)
 				paused = !paused;
 			break;
+		case 'b':
+			if(event.state == SDL_RELEASED)
+				backend->Benchmark();
+			break;
+		case 'i':
+			if(event.state == SDL_RELEASED)
+			{
+				integrator = integrator == Integrator::Leapfrog ? Integrator::SymplecticEuler : Integrator::Leapfrog;
+				Logger::Info() << "Integrator: " << (integrator == Integrator::Leapfrog ? "Leapfrog" : "Symplectic Euler") << '\n';
+			}
+			break;
 			// 视角控制：W/S 垂直，A/D 水平
 			case 'w':
 				if(event.state == SDL_PRESSED)
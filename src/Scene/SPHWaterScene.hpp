@@ -12,14 +12,16 @@
 #include "../Helper/ShaderStorage.hpp"
 
 #include "../SPHSimulation/SimulationState.hpp"
-
-#include "../Program/GridProgram.hpp"
-#include "../Program/SimulationProgram.hpp"
+#include "../SPHSimulation/SimulationBackend.hpp"
+#include "../SPHSimulation/SimulationConfig.hpp"
+#include "../SPHSimulation/AdaptiveTimestep.hpp"
 
 #include "../Program/Render/RenderSurface.hpp"
 #include "../Program/Render/RenderPoints.hpp"
 #include "../Program/Render/RenderEdgePoints.hpp"
 
+#include "../Main/SubstepScheduler.h"
+
 #include <GL/glew.h>
 
 /**
@@ -39,14 +41,8 @@ public:
 	};
 
 private:
-	GL::Program gravityProgram;
-
-	GLint targetLocation;
-	GLint dtLocation;
-
 	SimulationState state;
-	GridProgram grid;
-	SimulationProgram simulation;
+	std::unique_ptr<SimulationBackend> backend;
 	RenderSurface renderSurface;
 	RenderPoints renderPoints;
 	RenderEdgePoints renderEdgePoints;
@@ -54,35 +50,61 @@ private:
 	RenderMode renderMode;
 	bool distanceFieldDirty;
 
+	// 模拟推进后边缘粒子过期，只在表面或边缘点模式下重新提取
+	bool edgesDirty;
+
 	float time;
-	float timeRemainder;
+	SubstepScheduler substeps;
+
+	// 启用时每帧按 CFL 条件重新选取步长，否则固定为 stepTime / 2
+	bool adaptiveTimestep;
+	SPH::AdaptiveTimestep timestep;
+
+	// 上次输出速度比时的值，每个统计窗口只输出一次
+	double reportedSpeedRatio;
 
 	bool paused;
 
+	// 上次报告的溢出单元数，仅在变化时输出日志
+	unsigned reportedOverflowCells;
+
+	// 当前积分方式，按 i 在半隐式欧拉与蛙跳之间切换
+	Integrator integrator;
+
 	// Rigid body obstacle control
 	bool rigidEnabled;
 	float rigidRadius;
 
 	static constexpr float stepTime = 0.016666666666;
+
+	void ExtractEdges();
 public:
 	/**
 	 * @brief 构造函数，初始化模拟状态和各种渲染、计算模块。
+	 * @param config 模拟配置，决定粒子数、网格分辨率与计算后端。
 	 */
-	SPHWaterScene() :
-		state(32, 64, 64, 20),
-		grid(state),
-		simulation(state),
+	SPHWaterScene(const SimulationConfig& config = SimulationConfig()) :
+		state(config),
+		backend(CreateSimulationBackend(config, state)),
 		renderSurface(state),
 		renderPoints(state),
 		renderEdgePoints(state),
 		renderMode(RenderMode::Surface),
 		distanceFieldDirty(true),
+		edgesDirty(true),
 		time(0),
-		timeRemainder(0),
+		substeps(config.UsesAdaptiveTimestep() ? 2 * config.minTimestep : stepTime, config.maxSubsteps),
+		adaptiveTimestep(config.UsesAdaptiveTimestep()),
+		timestep(config.courantNumber, config.minTimestep, config.maxTimestep),
+		reportedSpeedRatio(0),
 		paused(false),
+		reportedOverflowCells(0),
+		integrator(config.integrator),
 		rigidEnabled(false),
 		rigidRadius(0.3f)
 	{
+		renderSurface.SetRenderScale(config.renderScale);
+		renderSurface.SetCheckerboard(config.checkerboard);
 	}
 
 	virtual bool Begin() override;
@@ -90,6 +112,16 @@ public:
 	virtual void Pause() override;
 	virtual void Update(const double) override;
 
+	/**
+	 * @brief 最近约一秒内模拟时间与真实时间之比。
+	 *
+	 * 每步积分的模拟时间是该步所占真实时间的一半，因此跟上帧率时该值为 0.5，低于此值说明在丢弃积压。
+	 */
+	double SimulatedToRealRatio() const
+	{
+		return substeps.SimulatedToRealRatio();
+	}
+
 	virtual void PrepareRender() override;
 	virtual void Render() override;
 